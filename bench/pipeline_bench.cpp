@@ -0,0 +1,593 @@
+// -----------------------------------------------------------------------------
+// Input Pipeline Benchmark — host ([env:native]) and AVR ([env:bench_avr])
+// -----------------------------------------------------------------------------
+// Runs the firmware's pipeline library (lib/QuadrantPipeline) without the
+// hardware: every filter, the curves, the deadband, the trim engine and the
+// debouncer on their own, then a full axis scan built from the firmware's
+// own axis table (include/AxisTable.h): each axis gets its filter, default
+// calibration, curve and deadband, or the trim engine, as it does on the
+// quadrant. Input reaches the scan through the pipeline's AxisSource and
+// ButtonSource interfaces, as the ADC rings and expanders feed the firmware.
+//
+// The stages run on a deterministic synthetic sweep; the full scan runs on
+// the sweep too, or on the host on a capture from tools/quadrant_capture.py.
+// Each run prints a checksum of the full scan's outputs, so a filter or
+// deadband variant can be checked for behaviour changes as well as cost:
+//   pio run -e native && .pio/build/native/program [capture.csv] [--budget-ns N]
+// On synthetic input the checksum must match GOLDEN_CHECKSUM or the run
+// fails; a change that alters the output on purpose updates the constant.
+// On the host costs are ns (and TSC cycles on x86); --budget-ns fails the
+// run when a full scan costs more. The AVR build counts CPU cycles with
+// Timer1 and prints them on USART1; tools/simavr_bench.sh runs it under
+// simavr and applies a cycle budget the same way.
+#include <QuadrantPipeline.h>
+#include "AxisTable.h"
+
+#ifdef __AVR__
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <stdio.h>
+#else
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+// Default calibration of each table axis, in AXIS_SAMPLE_BITS counts
+constexpr int benchRawMin(uint8_t axis)
+{
+  return AXIS_TABLE[axis].rawMin << ADC_OVERSAMPLE_BITS;
+}
+
+constexpr int benchRawSpan(uint8_t axis)
+{
+  return clampAxisSpan((long)(AXIS_TABLE[axis].rawMax - AXIS_TABLE[axis].rawMin) << ADC_OVERSAMPLE_BITS);
+}
+
+constexpr uint8_t firstTrimAxis(uint8_t i = 0)
+{
+  return i >= NUM_AXES || AXIS_TABLE[i].mode == AXIS_VIRTUAL_TRIM ? i : firstTrimAxis(i + 1);
+}
+
+// The trim stage runs on the table's trim axis, or on axis 0 if it has none
+const uint8_t BENCH_TRIM_AXIS = firstTrimAxis() < NUM_AXES ? firstTrimAxis() : 0;
+const uint8_t BENCH_CHIPS = 2; // one 32-bit button word
+static_assert(NUM_AXES <= 16, "ScanInput.fresh has a bit per axis");
+
+#ifdef __AVR__
+const uint16_t SYNTHETIC_SCANS = 256; // shorter: simavr runs at a few MHz
+#else
+const uint32_t SYNTHETIC_SCANS = 200000;
+#endif
+
+// Full-scan checksums of the synthetic input with the default table and
+// sampling. The AVR run is the first 256 scans of the host's and must match
+// with 16-bit ints too. Other profiles and sample widths are not checked.
+#if ADC_OVERSAMPLE_BITS != 2 || defined(QUADRANT_AXIS_PROFILE)
+const uint32_t GOLDEN_CHECKSUM = 0; // none
+#elif defined(__AVR__)
+const uint32_t GOLDEN_CHECKSUM = 0x307a0a9fUL;
+#else
+const uint32_t GOLDEN_CHECKSUM = 0xa752c0b5UL;
+#endif
+
+FilterTuning filterTuning = {ONE_EURO_MIN_ALPHA, ONE_EURO_BETA};
+TrimTuning trimTuning = {256, TRIM_NOISE_COUNTS};
+AxisCalibration calibration[NUM_AXES];
+int rawSpan[NUM_AXES];
+uint16_t userCurve[CURVE_POINTS];
+
+// The table defaults, as DefaultCalibration sets them in the firmware (the
+// table is in flash on the AVR, so it is only read at compile time)
+template <uint8_t I>
+struct BenchCalibration
+{
+  static void run()
+  {
+    constexpr int rawMin = benchRawMin(I);
+    constexpr int span = benchRawSpan(I);
+    calibration[I].rawMin = rawMin;
+    calibration[I].scale = scaleForSpan(span);
+    rawSpan[I] = span;
+  }
+};
+
+// Fletcher-style sum over every output, so runs can be compared
+uint16_t checkSum1 = 0, checkSum2 = 0;
+
+inline void check(int value)
+{
+  checkSum1 = (checkSum1 + (uint16_t)value) % 65535;
+  checkSum2 = (checkSum2 + checkSum1) % 65535;
+}
+
+inline bool checksumMatches()
+{
+  return !GOLDEN_CHECKSUM || (((uint32_t)checkSum2 << 16) | checkSum1) == GOLDEN_CHECKSUM;
+}
+
+// -----------------------------------------------------------------------------
+// Timing
+// -----------------------------------------------------------------------------
+#ifdef __AVR__
+volatile uint16_t timerOverflows = 0;
+
+ISR(TIMER1_OVF_vect)
+{
+  timerOverflows++;
+}
+
+struct Stopwatch
+{
+  uint32_t start;
+
+  static uint32_t now()
+  {
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t low = TCNT1;
+    uint16_t high = timerOverflows;
+    if ((TIFR1 & (1 << TOV1)) && low < 0x8000)
+      high++; // overflow pending, not yet counted
+    SREG = sreg;
+    return ((uint32_t)high << 16) | low;
+  }
+
+  void begin() { start = now(); }
+  uint32_t cycles() const { return now() - start; }
+};
+
+int putUart(char c, FILE *)
+{
+  while (!(UCSR1A & (1 << UDRE1)))
+    ;
+  UDR1 = c;
+  return 0;
+}
+
+FILE uartOut;
+
+void setupPlatform()
+{
+  UBRR1 = 7; // 125000 baud at 16 MHz; simavr ignores the rate
+  UCSR1B = (1 << TXEN1);
+  UCSR1C = (1 << UCSZ11) | (1 << UCSZ10);
+  fdev_setup_stream(&uartOut, putUart, NULL, _FDEV_SETUP_WRITE);
+  stdout = &uartOut;
+
+  TCCR1A = 0;
+  TCCR1B = (1 << CS10); // clk/1: one count per CPU cycle
+  TIMSK1 = (1 << TOIE1);
+  sei();
+}
+#else
+struct Stopwatch
+{
+  std::chrono::steady_clock::time_point start;
+  uint64_t startCycles;
+
+  static uint64_t tsc()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+  }
+
+  void begin()
+  {
+    startCycles = tsc();
+    start = std::chrono::steady_clock::now();
+  }
+
+  double ns() const
+  {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  uint64_t cycles() const { return tsc() - startCycles; }
+};
+
+void setupPlatform() {}
+#endif
+
+// One result line per stage: cost per operation
+struct Result
+{
+  const char *name;
+  uint32_t ops;
+#ifdef __AVR__
+  uint32_t cycles;
+#else
+  double ns;
+  uint64_t cycles;
+#endif
+};
+
+void printResult(const Result &r)
+{
+#ifdef __AVR__
+  printf("%-16s %8lu cycles/op  (%lu ops)\n", r.name, (unsigned long)(r.cycles / r.ops), (unsigned long)r.ops);
+#else
+  printf("%-16s %8.2f ns/op", r.name, r.ns / r.ops);
+  if (r.cycles)
+    printf("  %8.1f cycles/op", (double)r.cycles / r.ops);
+  printf("  (%lu ops)\n", (unsigned long)r.ops);
+#endif
+}
+
+template <typename Body>
+Result measure(const char *name, uint32_t ops, Body body)
+{
+  Stopwatch watch;
+  watch.begin();
+  for (uint32_t i = 0; i < ops; i++)
+  {
+    body(i);
+  }
+#ifdef __AVR__
+  Result r = {name, ops, watch.cycles()};
+#else
+  double ns = watch.ns();
+  Result r = {name, ops, ns, watch.cycles()};
+#endif
+  printResult(r);
+  return r;
+}
+
+// -----------------------------------------------------------------------------
+// Input
+// -----------------------------------------------------------------------------
+// Synthetic: every axis sweeps a triangle at its own rate with LCG noise of
+// a few counts, the trim pot spins, and the buttons change every 64 scans.
+uint32_t noiseState = 12345;
+
+inline int noise()
+{
+  noiseState = noiseState * 1103515245UL + 12345;
+  return (int)((noiseState >> 16) & 7) - 4;
+}
+
+inline int syntheticSample(uint8_t axis, uint32_t scan)
+{
+  uint32_t period = 2048 + 256 * axis;
+  uint32_t phase = (scan * 8) % (2 * period);
+  int span = rawSpan[axis];
+  int position = (int)((phase < period ? phase : 2 * period - phase) * span / period);
+  int sample = calibration[axis].rawMin + position + noise();
+  return sample < 0 ? 0 : sample > AXIS_OUTPUT_MAX ? AXIS_OUTPUT_MAX : sample;
+}
+
+inline uint32_t syntheticButtons(uint32_t scan)
+{
+  return (scan >> 6) & 1 ? 0x5UL << ((scan >> 7) & 15) : 0;
+}
+
+struct ScanInput
+{
+  uint32_t us;
+  uint16_t fresh; // bit n: axis n has a new sample
+  int samples[NUM_AXES];
+  uint32_t buttons;
+};
+
+#ifndef __AVR__
+// Capture from tools/quadrant_capture.py (t_us,source,value), grouped into
+// scans by timestamp; button words are held between changes.
+ScanInput *captureScans = NULL;
+uint32_t captureScanCount = 0;
+
+void appendScan(const ScanInput &scan, uint32_t &capacity)
+{
+  if (captureScanCount == capacity)
+  {
+    capacity *= 2;
+    captureScans = (ScanInput *)realloc(captureScans, capacity * sizeof(ScanInput));
+  }
+  captureScans[captureScanCount++] = scan;
+}
+
+bool loadCapture(const char *path)
+{
+  FILE *file = fopen(path, "r");
+  if (!file)
+    return false;
+  uint32_t capacity = 1024;
+  captureScans = (ScanInput *)malloc(capacity * sizeof(ScanInput));
+  char line[96];
+  ScanInput scan = {0, 0, {0}, 0};
+  bool open = false;
+  if (!fgets(line, sizeof(line), file)) // header
+    line[0] = 0;
+  while (fgets(line, sizeof(line), file))
+  {
+    unsigned long us;
+    char source[24];
+    char value[24];
+    if (sscanf(line, "%lu,%23[^,],%23s", &us, source, value) != 3)
+      continue;
+    if (open && us != scan.us)
+    {
+      appendScan(scan, capacity);
+      scan.fresh = 0;
+    }
+    open = true;
+    scan.us = us;
+    long v = strtol(value, NULL, 0);
+    if (source[0] == 'a')
+    {
+      int axis = atoi(source + 4);
+      if (axis >= 0 && axis < NUM_AXES)
+      {
+        scan.samples[axis] = (int)v;
+        scan.fresh |= 1 << axis;
+      }
+    }
+    else if (atoi(source + 7) == 0) // buttons0
+    {
+      scan.buttons = (uint32_t)strtoul(value, NULL, 0);
+    }
+  }
+  if (open)
+    appendScan(scan, capacity);
+  fclose(file);
+  return captureScanCount > 0;
+}
+#endif
+
+inline void getScan(uint32_t scan, ScanInput &input)
+{
+#ifndef __AVR__
+  if (captureScanCount)
+  {
+    input = captureScans[scan % captureScanCount];
+    return;
+  }
+#endif
+  input.us = scan * 1000;
+  input.fresh = 0;
+  for (uint8_t axis = 0; axis < NUM_AXES; axis++)
+  {
+    if ((scan + axis) % 6 == 0) // ~160 samples/s per axis at a 1 ms scan
+    {
+      input.samples[axis] = syntheticSample(axis, scan);
+      input.fresh |= 1 << axis;
+    }
+  }
+  input.buttons = syntheticButtons(scan);
+}
+
+// -----------------------------------------------------------------------------
+// Full Scan
+// -----------------------------------------------------------------------------
+// One scan's input as the pipeline's AxisSource and ButtonSource: each axis
+// flagged fresh yields its sample once, and the button word is split into
+// the two chips it comes from.
+struct ScanSource
+{
+  const ScanInput &input;
+  uint16_t fresh;
+
+  inline bool take(uint8_t axis, int &sample)
+  {
+    if (!(fresh & (1 << axis)))
+      return false;
+    fresh &= ~(1 << axis);
+    sample = input.samples[axis];
+    return true;
+  }
+
+  inline bool read(uint8_t chip, uint16_t &pressed)
+  {
+    pressed = input.buttons >> (16 * chip);
+    return true;
+  }
+};
+
+// What readAxes() does per scan for axis I and the ones after it, with the
+// table's filter, curve, deadband and mode. The trim engine reads the latest
+// raw sample, as AxisOutput does for a trim axis.
+template <uint8_t I = 0, bool Done = (I >= NUM_AXES)>
+struct BenchAxes
+{
+  AxisFilterState<AXIS_TABLE[I].filter> filter;
+  TrimEngine trim;
+  int raw;
+  int stable;
+  BenchAxes<I + 1> rest;
+
+  void prime(int sample)
+  {
+    filter.prime(sample);
+    trim.prime(sample, 0, TRIM_Q_MID);
+    raw = sample;
+    stable = 0;
+    rest.prime(sample);
+  }
+
+  inline void scan(ScanSource &source, uint32_t us)
+  {
+    constexpr AxisMode mode = AXIS_TABLE[I].mode;
+    constexpr AxisCurve curve = AXIS_TABLE[I].curve;
+    constexpr uint8_t deadband = AXIS_TABLE[I].deadband;
+    constexpr int span = benchRawSpan(I);
+    drainAxis(source, I, filter, filterTuning, raw);
+    if (mode == AXIS_VIRTUAL_TRIM)
+    {
+      trim.update(raw, us, span, trimTuning);
+      check(trim.output());
+    }
+    else
+    {
+      int mapped = applyCurve(curve, scaleAxis(filter.average(), calibration[I]), userCurve);
+      check(applyDeadband(mapped, stable, deadband));
+    }
+    rest.scan(source, us);
+  }
+};
+
+template <uint8_t I>
+struct BenchAxes<I, true>
+{
+  void prime(int) {}
+  inline void scan(ScanSource &, uint32_t) {}
+};
+
+// What readAxes() and readButtons() do per scan
+struct BenchPipeline
+{
+  BenchAxes<> axes;
+  ButtonDebouncer debouncer;
+
+  void prime(int sample)
+  {
+    axes.prime(sample);
+    debouncer.reset(0);
+  }
+
+  inline void scan(const ScanInput &in)
+  {
+    ScanSource source = {in, in.fresh};
+    axes.scan(source, in.us);
+    uint32_t buttons = 0;
+    sampleButtons(source, BENCH_CHIPS, &debouncer, &buttons);
+    check((int)debouncer.update(buttons));
+  }
+};
+
+// -----------------------------------------------------------------------------
+// Stages
+// -----------------------------------------------------------------------------
+template <AxisFilter F>
+void benchFilter(const char *name, uint32_t ops)
+{
+  AxisFilterState<F> filter;
+  filter.prime(calibration[0].rawMin);
+  measure(name, ops, [&](uint32_t i) {
+    filter.push(syntheticSample(0, i), filterTuning);
+    check(filter.average());
+  });
+}
+
+#ifdef __AVR__
+int main()
+#else
+int main(int argc, char **argv)
+#endif
+{
+  setupPlatform();
+  UnrollAxes<BenchCalibration>::run();
+  for (uint8_t i = 0; i < CURVE_POINTS; i++)
+  {
+    userCurve[i] = ((uint32_t)i << CURVE_UNIT_BITS) / CURVE_SEGMENTS - (i == CURVE_SEGMENTS);
+  }
+
+  uint32_t ops = SYNTHETIC_SCANS;
+#ifndef __AVR__
+  double budgetNs = 0;
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--budget-ns") && i + 1 < argc)
+    {
+      budgetNs = atof(argv[++i]);
+    }
+    else if (!loadCapture(argv[i]))
+    {
+      fprintf(stderr, "cannot read capture %s\n", argv[i]);
+      return 2;
+    }
+  }
+  if (captureScanCount)
+  {
+    printf("capture: %lu scans\n", (unsigned long)captureScanCount);
+    ops = captureScanCount;
+  }
+#endif
+
+  benchFilter<FILTER_BOXCAR>("boxcar", ops);
+  benchFilter<FILTER_EMA>("ema", ops);
+  benchFilter<FILTER_ONE_EURO>("one-euro", ops);
+  benchFilter<FILTER_MEDIAN3>("median3", ops);
+
+  measure("scale+linear", ops, [](uint32_t i) { check(applyCurve(CURVE_LINEAR, scaleAxis(syntheticSample(1, i), calibration[1]), userCurve)); });
+  measure("scale+s-curve", ops, [](uint32_t i) { check(applyCurve(CURVE_S, scaleAxis(syntheticSample(1, i), calibration[1]), userCurve)); });
+  measure("scale+user", ops, [](uint32_t i) { check(applyCurve(CURVE_USER, scaleAxis(syntheticSample(1, i), calibration[1]), userCurve)); });
+
+  int stable = 0;
+  measure("deadband", ops, [&](uint32_t i) { check(applyDeadband(syntheticSample(3, i), stable, 4)); });
+
+  TrimEngine trim;
+  trim.prime(calibration[BENCH_TRIM_AXIS].rawMin, 0, TRIM_Q_MID);
+  measure("trim", ops, [&](uint32_t i) {
+    trim.update(syntheticSample(BENCH_TRIM_AXIS, i * 3), i * 1000, rawSpan[BENCH_TRIM_AXIS], trimTuning);
+    check(trim.output());
+  });
+
+  ButtonDebouncer debouncer;
+  debouncer.reset(0);
+  measure("debounce", ops, [&](uint32_t i) { check((int)debouncer.update(syntheticButtons(i))); });
+
+  // Input is generated up front so the scan timing is pipeline only
+  BenchPipeline pipeline;
+  pipeline.prime(calibration[0].rawMin);
+  checkSum1 = checkSum2 = 0; // the scan checksum covers the full scan alone
+#ifdef __AVR__
+  uint32_t scanCycles = 0;
+  for (uint32_t i = 0; i < ops; i++)
+  {
+    ScanInput input;
+    getScan(i, input);
+    Stopwatch watch;
+    watch.begin();
+    pipeline.scan(input);
+    scanCycles += watch.cycles();
+  }
+  Result scanResult = {"full scan", ops, scanCycles};
+  printResult(scanResult);
+  printf("checksum %04x%04x\n", checkSum2, checkSum1);
+  if (!checksumMatches())
+    printf("FAIL: checksum, expected %08lx\n", (unsigned long)GOLDEN_CHECKSUM);
+  printf("scan cycles=%lu\n", (unsigned long)(scanCycles / ops));
+  cli();
+  sleep_cpu(); // simavr exits here
+  return 0;
+#else
+  const uint32_t BATCH = 1024;
+  ScanInput *batch = (ScanInput *)malloc(BATCH * sizeof(ScanInput));
+  double scanNs = 0;
+  uint64_t scanTsc = 0;
+  for (uint32_t done = 0; done < ops; done += BATCH)
+  {
+    uint32_t n = ops - done < BATCH ? ops - done : BATCH;
+    for (uint32_t i = 0; i < n; i++)
+      getScan(done + i, batch[i]);
+    Stopwatch watch;
+    watch.begin();
+    for (uint32_t i = 0; i < n; i++)
+      pipeline.scan(batch[i]);
+    scanNs += watch.ns();
+    scanTsc += watch.cycles();
+  }
+  free(batch);
+  Result scanResult = {"full scan", ops, scanNs, scanTsc};
+  printResult(scanResult);
+  printf("checksum %04x%04x\n", checkSum2, checkSum1);
+
+  if (!captureScanCount && !checksumMatches())
+  {
+    printf("FAIL: checksum, expected %08lx: the pipeline's output changed\n", (unsigned long)GOLDEN_CHECKSUM);
+    return 1;
+  }
+  if (budgetNs > 0 && scanNs / ops > budgetNs)
+  {
+    printf("FAIL: full scan %.2f ns over the %.2f ns budget\n", scanNs / ops, budgetNs);
+    return 1;
+  }
+  return 0;
+#endif
+}
@@ -0,0 +1,112 @@
+// -----------------------------------------------------------------------------
+// Axis Descriptor Table
+// -----------------------------------------------------------------------------
+// Every axis is declared once, here: pin, calibration, filter, deadband, how
+// it is processed, which HID usage it drives and its default response curve.
+// The scan is unrolled per entry at compile time (UnrollAxes below), so these
+// fold into immediates and no per-axis branching is left at runtime. The table
+// and its labels live in flash; the few loops that index it at runtime go
+// through axisDescriptor(). A per-aircraft build can replace the table with a
+// header from include/, e.g.
+//   build_flags = -DQUADRANT_AXIS_PROFILE=\"axis_profile_c172.h\"
+//
+// The firmware, bench/pipeline_bench.cpp and the native unit tests all build
+// from this one table, so the bench always measures the axes as configured.
+#pragma once
+
+#include <QuadrantPipeline.h>
+
+#ifndef ARDUINO
+// Leonardo analog pin numbers, for host builds without the Arduino core
+const uint8_t A0 = 18, A1 = 19, A2 = 20, A3 = 21, A4 = 22, A5 = 23, A6 = 24;
+#endif
+
+enum AxisMode : uint8_t
+{
+  AXIS_ABSOLUTE,    // filtered, scaled and deadbanded lever position
+  AXIS_VIRTUAL_TRIM // relative movement accumulated into a virtual trim wheel
+};
+
+enum HidAxis : uint8_t
+{
+  HID_X_AXIS,
+  HID_Y_AXIS,
+  HID_Z_AXIS,
+  HID_RX_AXIS,
+  HID_RY_AXIS,
+  HID_RZ_AXIS,
+  HID_THROTTLE // Simulation Controls throttle; DirectInput lists it as Slider1
+};
+
+// AxisFilter and AxisCurve come from the pipeline library (lib/QuadrantPipeline).
+// The curve is the last column, so a profile that leaves it out gets CURVE_LINEAR.
+struct AxisDescriptor
+{
+  uint8_t pin;
+  int rawMin; // default calibration in 10-bit analogRead() counts
+  int rawMax;
+  AxisFilter filter;
+  uint8_t deadband; // minimum change in output counts (0..AXIS_OUTPUT_MAX) before it is reported
+  AxisMode mode;
+  HidAxis hid;
+  const char *label; // PROGMEM string
+  AxisCurve curve;
+};
+
+#ifdef QUADRANT_AXIS_PROFILE
+#include QUADRANT_AXIS_PROFILE
+#else
+const char LABEL_THROTTLE_L[] PROGMEM = "Throttle L";
+const char LABEL_THROTTLE_R[] PROGMEM = "Throttle R";
+const char LABEL_TRIM[] PROGMEM = "Trim";
+const char LABEL_MIXTURE_1[] PROGMEM = "Mixture 1";
+const char LABEL_MIXTURE_2[] PROGMEM = "Mixture 2";
+const char LABEL_TBD_AXIS[] PROGMEM = "TBD Axis";
+const char LABEL_AXIS_7[] PROGMEM = "Axis 7";
+
+constexpr AxisDescriptor AXIS_TABLE[] PROGMEM = {
+    // pin rawMin rawMax  filter     deadband  mode               HID          label         curve
+    {A0, 196, 1023, FILTER_ONE_EURO, 4, AXIS_ABSOLUTE, HID_X_AXIS, LABEL_THROTTLE_L, CURVE_LINEAR},
+    {A1, 196, 1023, FILTER_ONE_EURO, 4, AXIS_ABSOLUTE, HID_Y_AXIS, LABEL_THROTTLE_R, CURVE_LINEAR},
+    {A2, 196, 1023, FILTER_BOXCAR, 0, AXIS_VIRTUAL_TRIM, HID_Z_AXIS, LABEL_TRIM, CURVE_LINEAR},
+    {A3, 196, 1023, FILTER_EMA, 0, AXIS_ABSOLUTE, HID_RX_AXIS, LABEL_MIXTURE_1, CURVE_LINEAR},
+    {A4, 196, 1023, FILTER_EMA, 0, AXIS_ABSOLUTE, HID_RY_AXIS, LABEL_MIXTURE_2, CURVE_LINEAR},
+    {A5, 196, 1023, FILTER_EMA, 0, AXIS_ABSOLUTE, HID_RZ_AXIS, LABEL_TBD_AXIS, CURVE_LINEAR},
+    {A6, 196, 1023, FILTER_EMA, 0, AXIS_ABSOLUTE, HID_THROTTLE, LABEL_AXIS_7, CURVE_LINEAR},
+};
+#endif
+
+const uint8_t NUM_AXES = sizeof(AXIS_TABLE) / sizeof(AXIS_TABLE[0]);
+
+// Runtime-indexed copy of one AXIS_TABLE row out of flash
+inline AxisDescriptor axisDescriptor(uint8_t i)
+{
+  AxisDescriptor d;
+  memcpy_P(&d, &AXIS_TABLE[i], sizeof(d));
+  return d;
+}
+
+constexpr bool tableUsesHid(HidAxis target, uint8_t i = 0)
+{
+  return i < NUM_AXES && (AXIS_TABLE[i].hid == target || tableUsesHid(target, i + 1));
+}
+
+// UnrollAxes<Step>::run(args...) expands to Step<0>::run(args...);
+// Step<1>::run(args...); ...
+template <template <uint8_t> class Step, uint8_t I = 0, bool Done = (I >= NUM_AXES)>
+struct UnrollAxes
+{
+  template <typename... Args>
+  static inline void run(Args &...args)
+  {
+    Step<I>::run(args...);
+    UnrollAxes<Step, I + 1>::run(args...);
+  }
+};
+
+template <template <uint8_t> class Step, uint8_t I>
+struct UnrollAxes<Step, I, true>
+{
+  template <typename... Args>
+  static inline void run(Args &...) {}
+};
@@ -0,0 +1,159 @@
+// -----------------------------------------------------------------------------
+// Input Pipeline — axis smoothing filters
+// -----------------------------------------------------------------------------
+// AxisFilterState<F> holds one axis' filter state, so each axis only carries
+// the buffers its own filter type needs. All filters take and return
+// AXIS_SAMPLE_BITS samples; prime() must be called before the first push().
+#pragma once
+
+#include "PipelineConfig.h"
+
+enum AxisFilter : uint8_t
+{
+  FILTER_BOXCAR,   // rolling average over filterWindowSize samples
+  FILTER_EMA,      // exponential moving average, no buffer
+  FILTER_ONE_EURO, // EMA whose cutoff rises with speed: smooth at rest, fast in motion
+  FILTER_MEDIAN3   // median of the last three samples, rejects single spikes
+};
+
+// Live One-Euro tuning, Q8 (1.0 = 256); the other filters have no knobs
+struct FilterTuning
+{
+  int16_t oneEuroMinAlpha;
+  int16_t oneEuroBeta;
+};
+
+// Power-of-two window so the average is a shift and the index a mask
+const uint8_t FILTER_WINDOW_SHIFT = 3;
+const int filterWindowSize = 1 << FILTER_WINDOW_SHIFT;
+static_assert(((long)AXIS_OUTPUT_MAX << FILTER_WINDOW_SHIFT) <= 32767, "boxcar sum must fit an int");
+
+template <AxisFilter F>
+struct AxisFilterState;
+
+template <>
+struct AxisFilterState<FILTER_BOXCAR>
+{
+  int buffer[filterWindowSize];
+  int sum;
+  uint8_t index;
+
+  void prime(int value)
+  {
+    for (int i = 0; i < filterWindowSize; i++)
+    {
+      buffer[i] = value;
+    }
+    sum = value << FILTER_WINDOW_SHIFT;
+    index = 0;
+  }
+
+  inline void push(int sample, const FilterTuning &)
+  {
+    sum -= buffer[index];
+    buffer[index] = sample;
+    sum += sample;
+    index = (index + 1) & (filterWindowSize - 1);
+  }
+
+  inline int average() const
+  {
+    return sum >> FILTER_WINDOW_SHIFT;
+  }
+};
+
+// EMA: acc holds the average scaled by 2^EMA_SHIFT, so each sample costs a
+// subtract, a shift and an add. At ~160 decimated samples/s per axis,
+// EMA_SHIFT = 2 is a time constant of about 20 ms.
+const uint8_t EMA_SHIFT = 2;
+
+template <>
+struct AxisFilterState<FILTER_EMA>
+{
+  uint16_t acc;
+
+  void prime(int value)
+  {
+    acc = value << EMA_SHIFT;
+  }
+
+  inline void push(int sample, const FilterTuning &)
+  {
+    acc += sample - (acc >> EMA_SHIFT);
+  }
+
+  inline int average() const
+  {
+    return acc >> EMA_SHIFT;
+  }
+};
+
+// One-Euro (Casiez et al.) in integer form, adapted in the alpha domain:
+// the smoothing factor grows linearly with the filtered lag between input
+// and output, so a resting lever sees ONE_EURO_MIN_ALPHA (heavy smoothing)
+// and a moving one quickly approaches alpha = 1 (no lag).
+// Values are Q8 (1.0 = 256).
+const int ONE_EURO_MIN_ALPHA = 32; // ~1/8 at rest
+const int ONE_EURO_BETA = 8;       // alpha added per count of lag
+const uint8_t ONE_EURO_D_SHIFT = 3; // smoothing of the lag (speed) estimate
+
+template <>
+struct AxisFilterState<FILTER_ONE_EURO>
+{
+  int32_t value; // Q8
+  int32_t speed; // Q8, filtered |input - value|
+
+  void prime(int sample)
+  {
+    value = (int32_t)sample << 8;
+    speed = 0;
+  }
+
+  inline void push(int sample, const FilterTuning &tuning)
+  {
+    int32_t error = ((int32_t)sample << 8) - value;
+    speed += ((error < 0 ? -error : error) - speed) >> ONE_EURO_D_SHIFT;
+
+    int32_t alpha = tuning.oneEuroMinAlpha + ((speed >> 8) * tuning.oneEuroBeta);
+    if (alpha > 256)
+      alpha = 256;
+    value += (error * alpha) >> 8;
+  }
+
+  inline int average() const
+  {
+    return (value + 128) >> 8;
+  }
+};
+
+template <>
+struct AxisFilterState<FILTER_MEDIAN3>
+{
+  int history[3];
+  uint8_t index;
+
+  void prime(int value)
+  {
+    history[0] = history[1] = history[2] = value;
+    index = 0;
+  }
+
+  inline void push(int sample, const FilterTuning &)
+  {
+    history[index] = sample;
+    index = (index == 2) ? 0 : index + 1;
+  }
+
+  inline int average() const
+  {
+    int a = history[0], b = history[1], c = history[2];
+    if (a > b)
+    {
+      int t = a;
+      a = b;
+      b = t;
+    }
+    // a <= b: the median is c clamped into [a, b], the range of the other two
+    return (c < a) ? a : (c > b) ? b : c;
+  }
+};
@@ -0,0 +1,144 @@
+// -----------------------------------------------------------------------------
+// Input Pipeline — scaling, response curves and deadband
+// -----------------------------------------------------------------------------
+// A smoothed sample becomes a reported axis value in three steps:
+// scaleAxis() (calibration), applyCurve() (response curve) and
+// applyDeadband() (hold small changes).
+#pragma once
+
+#include "PipelineConfig.h"
+
+// Raw-to-output scaling replaces map(): out = ((avg - min) * scale) >> 10.
+const uint8_t AXIS_SCALE_SHIFT = 10;
+
+struct AxisCalibration
+{
+  int rawMin;     // in ADC sample counts
+  uint16_t scale; // output counts per sample count, Q10
+};
+
+// Spans under 64 sample counts are clamped to keep the scale within 16 bits
+constexpr uint32_t clampAxisSpan(long span)
+{
+  return span < 64 ? 64 : span;
+}
+
+constexpr uint16_t scaleForSpan(uint32_t span)
+{
+  return (((uint32_t)AXIS_OUTPUT_MAX << AXIS_SCALE_SHIFT) + span / 2) / span;
+}
+
+inline int scaleAxis(int average, const AxisCalibration &calibration)
+{
+  int rawMin = calibration.rawMin;
+  uint16_t scale = calibration.scale;
+
+  if (average <= rawMin)
+  {
+    return 0;
+  }
+  uint16_t offset = average - rawMin;
+  uint32_t scaled = ((uint32_t)offset * scale + (1UL << (AXIS_SCALE_SHIFT - 1))) >> AXIS_SCALE_SHIFT;
+  return scaled > (uint32_t)AXIS_OUTPUT_MAX ? AXIS_OUTPUT_MAX : (int)scaled;
+}
+
+// -----------------------------------------------------------------------------
+// Response Curves
+// -----------------------------------------------------------------------------
+// A curve is CURVE_POINTS evenly spaced outputs over the scaled input, kept
+// in 12-bit units whatever AXIS_SAMPLE_BITS is. One evaluation is two table
+// reads and a lerp. The built-in curves live in flash; the user curve is a
+// RAM table owned by the caller (the firmware keeps it in its runtime
+// parameters, since the application cannot write flash).
+enum AxisCurve : uint8_t
+{
+  CURVE_LINEAR,
+  CURVE_EXPO,    // fine control at the low end
+  CURVE_S,       // fine control at both ends
+  CURVE_DETENTS, // reverse, a flat idle detent, climb and a flat TOGA detent
+  CURVE_USER     // uploaded breakpoints (tools/quadrant_params.py curve)
+};
+
+const uint8_t CURVE_SEGMENTS = 32;
+const uint8_t CURVE_POINTS = CURVE_SEGMENTS + 1;
+const uint8_t CURVE_UNIT_BITS = 12;
+const uint8_t CURVE_SEGMENT_BITS = CURVE_UNIT_BITS - 5; // 32 segments
+static_assert((1 << (CURVE_UNIT_BITS - CURVE_SEGMENT_BITS)) == CURVE_SEGMENTS, "segment size must match the table");
+static_assert(AXIS_SAMPLE_BITS <= CURVE_UNIT_BITS, "curves are tabulated in 12-bit units");
+
+// y = 0.4x + 0.6x^3
+const uint16_t CURVE_EXPO_TABLE[CURVE_POINTS] PROGMEM = {
+       0,   51,  103,  156,  210,  265,  323,  384,  448,  515,  587,
+     663,  744,  830,  922, 1021, 1126, 1239, 1359, 1487, 1624, 1769,
+    1925, 2090, 2265, 2451, 2649, 2858, 3079, 3313, 3560, 3821, 4095,
+};
+
+// y = 0.4x + 0.6 smoothstep(x)
+const uint16_t CURVE_S_TABLE[CURVE_POINTS] PROGMEM = {
+       0,   58,  130,  214,  310,  417,  534,  660,  793,  934, 1082,
+    1234, 1392, 1552, 1716, 1881, 2048, 2214, 2379, 2543, 2703, 2861,
+    3013, 3161, 3302, 3435, 3561, 3678, 3785, 3881, 3965, 4037, 4095,
+};
+
+// Lever travel 0-9% reverse (0-18%), 12-22% idle detent at 20%, climb to
+// 96% at 84%, 91-100% TOGA detent at full
+const uint16_t CURVE_DETENT_TABLE[CURVE_POINTS] PROGMEM = {
+       0,  246,  491,  737,  819,  819,  819,  819,  975, 1130, 1286,
+    1441, 1597, 1753, 1908, 2064, 2219, 2375, 2531, 2686, 2842, 2998,
+    3153, 3309, 3464, 3620, 3776, 3931, 4013, 4095, 4095, 4095, 4095,
+};
+
+const uint16_t *const CURVE_TABLES[] PROGMEM = {CURVE_EXPO_TABLE, CURVE_S_TABLE, CURVE_DETENT_TABLE};
+
+// userCurve holds CURVE_POINTS values for CURVE_USER
+inline int applyCurve(uint8_t curve, int value, const uint16_t *userCurve)
+{
+  if (curve == CURVE_LINEAR || curve > CURVE_USER)
+  {
+    return value;
+  }
+
+  // The breakpoints span 0..4096 (32 segments of 128) but the input stops at
+  // AXIS_OUTPUT_MAX: stretch it by 2^AXIS_SAMPLE_BITS / AXIS_OUTPUT_MAX,
+  // rounded, so full travel lands exactly on the last point
+  uint16_t x = (uint16_t)value << (CURVE_UNIT_BITS - AXIS_SAMPLE_BITS);
+  x += (x + (1 << (AXIS_SAMPLE_BITS - 1))) >> AXIS_SAMPLE_BITS;
+  uint8_t segment = x >> CURVE_SEGMENT_BITS;
+  uint8_t frac = x & ((1 << CURVE_SEGMENT_BITS) - 1);
+  if (segment == CURVE_SEGMENTS)
+  {
+    segment--;
+    frac = 1 << CURVE_SEGMENT_BITS;
+  }
+  int16_t y0, y1;
+  if (curve == CURVE_USER)
+  {
+    y0 = userCurve[segment];
+    y1 = userCurve[segment + 1];
+  }
+  else
+  {
+    const uint16_t *table = (const uint16_t *)pgm_read_ptr(&CURVE_TABLES[curve - CURVE_EXPO]);
+    y0 = pgm_read_word(&table[segment]);
+    y1 = pgm_read_word(&table[segment + 1]);
+  }
+  int16_t y = y0 + (((int32_t)(y1 - y0) * frac) >> CURVE_SEGMENT_BITS);
+  return y >> (CURVE_UNIT_BITS - AXIS_SAMPLE_BITS);
+}
+
+// -----------------------------------------------------------------------------
+// Deadband
+// -----------------------------------------------------------------------------
+// stable only follows mapped once it has moved at least deadband counts, so
+// noise within the band never reaches the host.
+inline int applyDeadband(int mapped, int &stable, uint8_t deadband)
+{
+  int delta = mapped - stable;
+  if (delta < 0)
+    delta = -delta;
+  if (delta >= deadband)
+  {
+    stable = mapped;
+  }
+  return stable;
+}
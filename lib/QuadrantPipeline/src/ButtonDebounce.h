@@ -0,0 +1,40 @@
+// -----------------------------------------------------------------------------
+// Input Pipeline — button debounce
+// -----------------------------------------------------------------------------
+// A 2-bit vertical counter per button, 32 buttons per word: bit n of low and
+// high together count how many samples button n has differed from its
+// debounced state. The counter runs 3, 2, 1, 0 and the state toggles when it
+// wraps to 3, i.e. on the fourth differing sample; any agreeing sample
+// resets it. A whole word updates in a few word operations.
+#pragma once
+
+#include "PipelineConfig.h"
+
+// Differing samples, taken one sample interval apart, before a change is taken
+const uint8_t DEBOUNCE_SAMPLES = 4;
+
+struct ButtonDebouncer
+{
+  uint32_t state; // debounced buttons, bit n set = pressed
+  uint32_t low;
+  uint32_t high;
+
+  // Takes sample as the debounced state, with every counter at rest
+  void reset(uint32_t sample)
+  {
+    state = sample;
+    low = 0xFFFFFFFFUL;
+    high = 0xFFFFFFFFUL;
+  }
+
+  // Feeds one sample; returns the buttons whose debounced state just toggled
+  inline uint32_t update(uint32_t sample)
+  {
+    uint32_t delta = sample ^ state;
+    low = ~(low & delta);
+    high = low ^ (high & delta);
+    uint32_t toggled = delta & low & high;
+    state ^= toggled;
+    return toggled;
+  }
+};
@@ -0,0 +1,57 @@
+// -----------------------------------------------------------------------------
+// Input Pipeline — hardware interfaces
+// -----------------------------------------------------------------------------
+// The two places a scan touches hardware, as small interfaces the scan steps
+// below are templated on. A source is any type with the member shown, so on
+// the AVR the binding inlines and costs no indirect call:
+//
+//   AxisSource    bool take(uint8_t axis, int &sample)
+//                 next AXIS_SAMPLE_BITS sample for the axis, false once drained
+//   ButtonSource  bool read(uint8_t chip, uint16_t &pressed)
+//                 one expander's 16 inputs, bit n set = pressed; false if the
+//                 chip could not be read this scan
+//
+// src/main.cpp binds them to the ADC ISR rings and the MCP23017 bursts; the
+// native unit tests and bench/pipeline_bench.cpp bind them to scripted input.
+#pragma once
+
+#include "PipelineConfig.h"
+#include "AxisFilters.h"
+#include "ButtonDebounce.h"
+
+// Feeds every sample the source has for the axis into its filter. Returns
+// false if there was none; latest is left at the last sample taken.
+template <typename AxisSource, AxisFilter F>
+inline bool drainAxis(AxisSource &source, uint8_t axis, AxisFilterState<F> &filter, const FilterTuning &tuning,
+                      int &latest)
+{
+  bool any = false;
+  int sample;
+  while (source.take(axis, sample))
+  {
+    filter.push(sample, tuning);
+    latest = sample;
+    any = true;
+  }
+  return any;
+}
+
+// Collects one 32-bit sample word per two chips (chip n in bits 16(n & 1) up
+// of word n / 2) for the debouncers. A chip that cannot be read holds its
+// debounced state, so a bus error reads as "nothing changed" rather than as
+// every button released. words must start zeroed.
+template <typename ButtonSource>
+inline void sampleButtons(ButtonSource &source, uint8_t chips, const ButtonDebouncer *debouncers, uint32_t *words)
+{
+  for (uint8_t chip = 0; chip < chips; chip++)
+  {
+    uint8_t w = chip >> 1;
+    uint8_t shift = (chip & 1) * 16;
+    uint16_t pressed;
+    if (!source.read(chip, pressed))
+    {
+      pressed = debouncers[w].state >> shift;
+    }
+    words[w] |= (uint32_t)pressed << shift;
+  }
+}
@@ -0,0 +1,41 @@
+// -----------------------------------------------------------------------------
+// Input Pipeline — build configuration and platform layer
+// -----------------------------------------------------------------------------
+// The pipeline headers are plain integer code with no Arduino dependency: the
+// firmware hands them ADC samples and button words and reads back outputs,
+// so the same code builds for the Leonardo and on a PC ([env:native]). The
+// only platform service they use is reading constant tables from flash,
+// which maps to plain memory reads off the AVR.
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef pgm_read_byte
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#endif
+#ifndef pgm_read_word
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+#endif
+#ifndef pgm_read_ptr
+#define pgm_read_ptr(address) (*(const void *const *)(address))
+#endif
+#ifndef memcpy_P
+#define memcpy_P memcpy
+#endif
+#endif
+
+// The ADC sampler oversamples 16x and decimates by 4, so filters work on
+// 12-bit samples and axes report 0..4095. Build with -DADC_OVERSAMPLE_BITS=0
+// for plain 10-bit sampling (0..1023) at a higher per-axis sample rate.
+#ifndef ADC_OVERSAMPLE_BITS
+#define ADC_OVERSAMPLE_BITS 2
+#endif
+const uint8_t AXIS_SAMPLE_BITS = 10 + ADC_OVERSAMPLE_BITS;
+const int AXIS_OUTPUT_MAX = (1 << AXIS_SAMPLE_BITS) - 1;
@@ -0,0 +1,17 @@
+// -----------------------------------------------------------------------------
+// MoonDog Throttle Quadrant — input pipeline
+// -----------------------------------------------------------------------------
+// The hardware-independent half of the firmware: axis filters, scaling,
+// response curves, deadband, the virtual trim engine and button debounce,
+// and the interfaces they read input through (InputSource.h).
+// src/main.cpp is the hardware side (ADC, MCP23017s, HID, EEPROM, serial)
+// and feeds these with samples; bench/pipeline_bench.cpp and the unit tests
+// in test/ drive them on a PC.
+#pragma once
+
+#include "PipelineConfig.h"
+#include "AxisFilters.h"
+#include "AxisMapping.h"
+#include "TrimEngine.h"
+#include "ButtonDebounce.h"
+#include "InputSource.h"
@@ -0,0 +1,92 @@
+// -----------------------------------------------------------------------------
+// Input Pipeline — virtual trim engine
+// -----------------------------------------------------------------------------
+// Reads a pot as a relative encoder and accumulates its movement into a
+// virtual trim wheel:
+// - Movement comes from the latest raw sample, not the smoothed average,
+//   so fast spins are neither lagged nor averaged away. A step is taken once
+//   the pot leaves a noise window around the last step.
+// - The step's speed (~counts/ms) picks a gain from TRIM_ACCEL_CURVE: slow
+//   turns give fine control, fast spins cover the range in a few turns.
+// - A step of more than half the pot's span is a wrap past the end of
+//   travel (continuous-rotation pots) and is unwrapped.
+// Persistence is left to the caller.
+#pragma once
+
+#include "PipelineConfig.h"
+
+// The accumulator is Q8 fixed point (1.0 = 256), so no float math is needed.
+const uint8_t TRIM_Q_SHIFT = 8;
+const int32_t TRIM_Q_MAX = (int32_t)AXIS_OUTPUT_MAX << TRIM_Q_SHIFT;
+const int32_t TRIM_Q_MID = ((int32_t)AXIS_OUTPUT_MAX + 1) << (TRIM_Q_SHIFT - 1);
+
+const int TRIM_NOISE_COUNTS = 2 << ADC_OVERSAMPLE_BITS;
+
+// Q8 output counts per raw count, indexed by the bit length of the speed:
+// <1, 1, 2-3, 4-7, 8-15, 16-31, 32-63 and >=64 counts/ms
+const uint16_t TRIM_ACCEL_CURVE[] PROGMEM = {64, 64, 96, 128, 192, 320, 512, 768};
+const uint8_t TRIM_ACCEL_STEPS = sizeof(TRIM_ACCEL_CURVE) / sizeof(TRIM_ACCEL_CURVE[0]);
+
+// Embedded in the firmware's EEPROM params block: keep the field order
+struct TrimTuning
+{
+  uint16_t gainScale;   // Q8 multiplier on TRIM_ACCEL_CURVE
+  uint16_t noiseCounts; // step threshold, raw counts
+};
+
+// The curve index is the bit length of distance * 1024 / dtUs (~counts/ms).
+// speed >= 2^k exactly when distance * 1024 >= dtUs << k, so the index is
+// found with shifts and compares instead of a 32-bit division.
+inline uint16_t trimGain(uint16_t distance, unsigned long dtUs)
+{
+  uint32_t scaled = (uint32_t)distance << 10;
+  uint32_t limit = dtUs ? dtUs : 1; // stops before it could overflow: limit <= scaled
+  uint8_t step = 0;
+  while (step < TRIM_ACCEL_STEPS - 1 && scaled >= limit)
+  {
+    limit <<= 1;
+    step++;
+  }
+  return pgm_read_word(&TRIM_ACCEL_CURVE[step]);
+}
+
+struct TrimEngine
+{
+  int32_t accumulated; // Q8
+  int anchor;             // raw position of the last step
+  unsigned long anchorUs; // when it was taken
+
+  void prime(int raw, unsigned long nowUs, int32_t value)
+  {
+    anchor = raw;
+    anchorUs = nowUs;
+    accumulated = value < 0 ? 0 : value > TRIM_Q_MAX ? TRIM_Q_MAX : value;
+  }
+
+  // Returns true when the accumulator moved. span is the pot's raw span.
+  inline bool update(int raw, unsigned long nowUs, int span, const TrimTuning &tuning)
+  {
+    int delta = raw - anchor;
+    if (delta > span / 2)
+      delta -= span;
+    else if (delta < -span / 2)
+      delta += span;
+
+    uint16_t distance = delta < 0 ? -delta : delta;
+    if (distance < tuning.noiseCounts)
+    {
+      return false;
+    }
+    uint16_t gain = ((uint32_t)trimGain(distance, nowUs - anchorUs) * tuning.gainScale) >> 8;
+    anchor = raw;
+    anchorUs = nowUs;
+    int32_t value = accumulated + (int32_t)delta * gain;
+    accumulated = value < 0 ? 0 : value > TRIM_Q_MAX ? TRIM_Q_MAX : value;
+    return true;
+  }
+
+  inline int output() const
+  {
+    return accumulated >> TRIM_Q_SHIFT;
+  }
+};
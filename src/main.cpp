@@ -1,18 +1,35 @@
 // -----------------------------------------------------------------------------
 // MoonDog Throttle Quadrant Firmware
 // Arduino Leonardo (ATmega32u4) USB HID Game Controller
-// - Reads 7 analog axes (Throttle 1–6, Axis 7 optional)
-// - Reads 32 buttons via two MCP23017 I2C expanders
+// - Reads 7 analog axes (Throttle 1–6, Axis 7 optional) from one descriptor table
+// - Reads 16 buttons per MCP23017 I2C expander, up to 8 chips (one burst read each)
+// - Debounces the buttons 32 at a time with vertical counters
+// - Samples axes in the background from the ADC conversion-complete ISR
+// - Oversamples and decimates for 12-bit axis resolution
 // - Implements rolling average smoothing for analog noise reduction
-// - Includes real-time serial monitor output with live updating
+// - Stores per-axis calibration in EEPROM (serial 'c' sweep)
+// - Includes real-time serial monitor output with live updating (non-blocking)
+// - Streams compact binary telemetry frames at scan rate (serial 'b')
+// - Applies per-axis response curves from interpolated lookup tables
 // - Adds adaptive deadband logic for Throttle L/R
-// - Adds virtual trim accumulator to simulate multi-turn trim wheel
+// - Optionally locks Throttle L/R to one value while they are within tolerance
+// - Adds a velocity-aware virtual trim accumulator, saved across power cycles
+// - Stages buttons and axes into one HID report committed once per scan
+// - Optionally drops to a low scan and report rate while the controls are idle
+// - Takes live parameter changes over a binary serial command channel
+// - Records raw input samples to the host and replays captured streams
+// - Keeps the hardware-free input pipeline in lib/QuadrantPipeline
 // -----------------------------------------------------------------------------
 
 #include <Wire.h>
 #include <Adafruit_MCP23X17.h>
 #include <Joystick.h>
 #include <PluggableUSB.h>
+#include <EEPROM.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include <QuadrantPipeline.h>
+#include "AxisTable.h"
 
 #ifndef _USING_DYNAMIC_HID
 #define _USING_DYNAMIC_HID
@@ -25,212 +42,2892 @@
 #endif
 
 // -----------------------------------------------------------------------------
-// Joystick HID Interface
+// Axis Samples
 // -----------------------------------------------------------------------------
-Joystick_ Joystick(JOYSTICK_DEFAULT_REPORT_ID,
-                   JOYSTICK_TYPE_MULTI_AXIS, 32, 2,
-                   true, true, true, // X, Y, Z
-                   true, true, true, // Rx, Ry, Rz
-                   false, false, false,
-                   false, false);
+// The axis descriptor table (AXIS_TABLE, NUM_AXES, UnrollAxes) is shared with
+// the bench and the unit tests, in include/AxisTable.h.
+
+// One record per axis per scan. The trim axis reports its accumulator as the
+// stable value. readAxes() is the only writer; the HID and telemetry stages
+// only read these, so sampling cost never depends on whether debug is on.
+struct AxisSample
+{
+  int raw;
+  int average;
+  int mapped;
+  int stable;
+};
+
+AxisSample axisSamples[NUM_AXES] = {{0, 0, 0, 0}};
+unsigned long axisScanUs = 0; // start of the current axis scan
 
 // -----------------------------------------------------------------------------
-// I/O Expanders (MCP23017) for 32 Button Inputs
+// Runtime Parameters
 // -----------------------------------------------------------------------------
-Adafruit_MCP23X17 mcp1;
-Adafruit_MCP23X17 mcp2;
+// Tunables the host can read and write live over the binary command channel
+// (see Binary Command Channel). The constants and build flags they replace
+// are only their defaults; a copy committed to EEPROM overrides them at boot.
+struct RuntimeParams
+{
+  uint16_t axisScanPeriodUs;
+  uint16_t buttonScanPeriodUs; // also the debounce sample interval
+  uint16_t keepaliveMs;        // 0 = no keepalive
+  uint16_t axisReportIntervalUs;
+  FilterTuning filter;
+  TrimTuning trim;
+  uint16_t syncTolerance; // throttle sync lock split, 0 = sync off
+  uint16_t syncRelease;   // throttle sync unlock split
+  uint16_t idleTimeoutMs;    // untouched this long drops to the idle rate, 0 = never
+  uint16_t idleScanPeriodUs; // both scans while idle
+  uint16_t idleKeepaliveMs;  // keepalive while idle, 0 = none
+  uint16_t idleWakeCounts;   // ADC step from the idle position that wakes, sample counts
+  uint8_t deadband[NUM_AXES];
+  uint8_t curve[NUM_AXES];            // AxisCurve
+  uint16_t userCurve[CURVE_POINTS];   // CURVE_USER breakpoints, 0..4095
+};
+
+RuntimeParams params;
 
 // -----------------------------------------------------------------------------
-// Axis Configuration and Smoothing Buffers
+// Smoothing and Scaling
 // -----------------------------------------------------------------------------
-const int NUM_AXES = 7;
-const int axisPins[NUM_AXES] = {A0, A1, A2, A3, A4, A5, A6};
+// The filters, scaling, curves, deadband and trim math live in the pipeline
+// library; this side binds them to the axis table. Filter state lives in
+// AxisSmoothing<I>, so each axis only carries the buffers its own filter
+// type needs.
+template <uint8_t I>
+struct AxisSmoothing
+{
+  static AxisFilterState<AXIS_TABLE[I].filter> state;
 
-const int AXIS_RAW_MIN[NUM_AXES] = {196, 196, 196, 196, 196, 196, 196};
-const int AXIS_RAW_MAX[NUM_AXES] = {1023, 1023, 1023, 1023, 1023, 1023, 1023};
+  static void prime(int value)
+  {
+    state.prime(value);
+  }
 
-const int filterWindowSize = 10;
-int axisBuffers[NUM_AXES][filterWindowSize] = {{0}};
-int axisSums[NUM_AXES] = {0};
-int axisIndices[NUM_AXES] = {0};
+  static inline void push(int sample)
+  {
+    state.push(sample, params.filter);
+  }
 
-const char *axisLabels[NUM_AXES] = {
-    "Throttle L", "Throttle R", "Trim", "Mixture 1",
-    "Mixture 2", "TBD Axis", "TBD Axis"};
+  static inline int average()
+  {
+    return state.average();
+  }
+};
 
-// -----------------------------------------------------------------------------
-// Adaptive Deadband & Virtual Trim Accumulation
-// -----------------------------------------------------------------------------
-int lastStableOutput[NUM_AXES] = {0};
-const int DEADZONE_THRESHOLDS[NUM_AXES] = {
-    1, 1, 0, 0, 0, 0, 0};
+template <uint8_t I>
+AxisFilterState<AXIS_TABLE[I].filter> AxisSmoothing<I>::state;
+
+// Raw-to-output scaling replaces map(). rawMin and scale come from
+// axisCalibration[], which holds the table's defaults (computed at compile
+// time) unless EEPROM has a stored calibration.
+AxisCalibration axisCalibration[NUM_AXES];
+
+constexpr int axisRawMin(uint8_t i)
+{
+  return AXIS_TABLE[i].rawMin << ADC_OVERSAMPLE_BITS;
+}
 
-// Virtual trim state (Z axis): accumulate relative movement for scaled response
-float accumulatedTrim = 512.0f; // Start at midpoint
-float lastTrimAvg = 0;
-const float TRIM_INCREMENT_SCALE = 0.5f;
-const int TRIM_AXIS_INDEX = 2; // Trim is axis 2
+constexpr uint16_t axisScale(uint8_t i)
+{
+  return scaleForSpan(clampAxisSpan((long)(AXIS_TABLE[i].rawMax - AXIS_TABLE[i].rawMin) << ADC_OVERSAMPLE_BITS));
+}
 
-int applyDeadband(int axisIndex, int currentMapped)
+template <uint8_t I>
+struct DefaultCalibration
 {
-  int delta = abs(currentMapped - lastStableOutput[axisIndex]);
-  if (delta >= DEADZONE_THRESHOLDS[axisIndex])
+  static void run()
   {
-    lastStableOutput[axisIndex] = currentMapped;
+    static_assert(AXIS_TABLE[I].rawMax > AXIS_TABLE[I].rawMin, "axis rawMax must be above rawMin");
+    constexpr int rawMin = axisRawMin(I);
+    constexpr uint16_t scale = axisScale(I);
+    axisCalibration[I].rawMin = rawMin;
+    axisCalibration[I].scale = scale;
   }
-  return lastStableOutput[axisIndex];
+};
+
+// Scaled and curved lever position, before the deadband
+template <uint8_t I>
+inline int mapAxis(int average)
+{
+  return applyCurve(params.curve[I], scaleAxis(average, axisCalibration[I]), params.userCurve);
 }
 
 // -----------------------------------------------------------------------------
-// Setup Routine
+// Axis Calibration — one CRC-checked EEPROM block
 // -----------------------------------------------------------------------------
-void setup()
+// The block stores each axis's rawMin and precomputed scale, so boot is one
+// EEPROM read and a CRC check with no divisions. A missing, stale or corrupt
+// block leaves the table defaults in place.
+//
+// Sweep: send 'c', move every lever end to end, send 'c' again to store.
+// 'x' abandons a sweep; 'd' restores the table defaults and clears the block.
+// Virtual trim axes are relative and keep their defaults.
+const int CALIBRATION_EEPROM_ADDRESS = 0;
+const uint16_t CALIBRATION_MAGIC = 0x5143; // "CQ"
+const uint8_t CALIBRATION_VERSION = 1;
+const int CALIBRATION_MARGIN = 2 << ADC_OVERSAMPLE_BITS;     // inset so the ends reach 0 and max
+const int CALIBRATION_MIN_SPAN = 64 << ADC_OVERSAMPLE_BITS;  // less travel = axis not swept
+
+struct CalibrationBlock
 {
-  Wire.begin();
-  mcp1.begin_I2C(0x20);
-  mcp2.begin_I2C(0x21);
+  uint16_t magic;
+  uint8_t version;
+  uint8_t axisCount;
+  uint8_t sampleBits; // AXIS_SAMPLE_BITS the block was recorded with
+  AxisCalibration axes[NUM_AXES];
+  uint16_t crc; // CRC-16 over every byte before it
+};
+
+bool calibrating = false;
+int calibrationMin[NUM_AXES];
+int calibrationMax[NUM_AXES];
+CalibrationBlock calibrationSave;
+uint8_t calibrationSaveNext = sizeof(CalibrationBlock); // == size: no save in progress
+
+uint16_t eepromCrc(const void *data, uint8_t length)
+{
+  const uint8_t *bytes = (const uint8_t *)data;
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 0; i < length; i++)
+  {
+    crc = _crc16_update(crc, bytes[i]);
+  }
+  return crc;
+}
+
+uint16_t calibrationCrc(const CalibrationBlock &block)
+{
+  return eepromCrc(&block, offsetof(CalibrationBlock, crc));
+}
+
+// Writes data[next] only if the EEPROM is idle, then advances next, so a
+// record is saved one byte per call and the ~3.4 ms each byte takes to
+// program never stalls the loop. Returns true once every byte is written.
+bool trickleWriteEeprom(int address, const uint8_t *data, uint8_t length, uint8_t &next)
+{
+  if (next < length && eeprom_is_ready())
+  {
+    EEPROM.update(address + next, data[next]);
+    next++;
+  }
+  return next >= length;
+}
+
+bool loadCalibration()
+{
+  CalibrationBlock block;
+  EEPROM.get(CALIBRATION_EEPROM_ADDRESS, block);
+  if (block.magic != CALIBRATION_MAGIC || block.version != CALIBRATION_VERSION ||
+      block.axisCount != NUM_AXES || block.sampleBits != AXIS_SAMPLE_BITS ||
+      block.crc != calibrationCrc(block))
+  {
+    return false;
+  }
+  memcpy(axisCalibration, block.axes, sizeof(axisCalibration));
+  return true;
+}
+
+// Queues the block; serviceCalibrationSave() writes it a byte at a time
+void storeCalibration()
+{
+  CalibrationBlock &block = calibrationSave;
+  memset(&block, 0, sizeof(block)); // zero any padding so the CRC is deterministic
+  block.magic = CALIBRATION_MAGIC;
+  block.version = CALIBRATION_VERSION;
+  block.axisCount = NUM_AXES;
+  block.sampleBits = AXIS_SAMPLE_BITS;
+  memcpy(block.axes, axisCalibration, sizeof(axisCalibration));
+  block.crc = calibrationCrc(block);
+  calibrationSaveNext = 0;
+}
+
+void serviceCalibrationSave()
+{
+  if (calibrationSaveNext < sizeof(CalibrationBlock))
+  {
+    trickleWriteEeprom(CALIBRATION_EEPROM_ADDRESS, (const uint8_t *)&calibrationSave, sizeof(CalibrationBlock),
+                       calibrationSaveNext);
+  }
+}
+
+void clearCalibration()
+{
+  UnrollAxes<DefaultCalibration>::run();
+  calibrationSaveNext = sizeof(CalibrationBlock); // drop a save still being written
+  EEPROM.update(CALIBRATION_EEPROM_ADDRESS, 0xFF); // breaks the magic
+}
 
-  for (int i = 0; i < 16; i++)
+void startCalibration()
+{
+  for (uint8_t i = 0; i < NUM_AXES; i++)
   {
-    mcp1.pinMode(i, INPUT_PULLUP);
-    mcp2.pinMode(i, INPUT_PULLUP);
+    calibrationMin[i] = axisSamples[i].average;
+    calibrationMax[i] = axisSamples[i].average;
   }
+  calibrating = true;
+}
 
-  Joystick.begin();
-  Serial.begin(9600);
-  while (!Serial)
+// Called after each axis scan while a sweep is running
+void trackCalibration()
+{
+  for (uint8_t i = 0; i < NUM_AXES; i++)
   {
+    int average = axisSamples[i].average;
+    if (average < calibrationMin[i])
+      calibrationMin[i] = average;
+    if (average > calibrationMax[i])
+      calibrationMax[i] = average;
   }
-  Serial.println("Throttle Debug Initialized");
+}
 
-  for (int a = 0; a < NUM_AXES; a++)
+int calibrationSpan(uint8_t i)
+{
+  return calibrationMax[i] - calibrationMin[i] - 2 * CALIBRATION_MARGIN;
+}
+
+// Whether the sweep covered enough of axis i to replace its calibration
+bool calibrationSwept(uint8_t i)
+{
+  return axisDescriptor(i).mode == AXIS_ABSOLUTE && calibrationSpan(i) >= CALIBRATION_MIN_SPAN;
+}
+
+// The range each axis saw goes out afterwards as a stats report (see Serial
+// Commands), so the sweep's results never block the loop
+void finishCalibration()
+{
+  calibrating = false;
+  for (uint8_t i = 0; i < NUM_AXES; i++)
   {
-    int initVal = analogRead(axisPins[a]);
-    for (int i = 0; i < filterWindowSize; i++)
+    if (calibrationSwept(i))
     {
-      axisBuffers[a][i] = initVal;
-      axisSums[a] += initVal;
+      axisCalibration[i].rawMin = calibrationMin[i] + CALIBRATION_MARGIN;
+      axisCalibration[i].scale = scaleForSpan(clampAxisSpan(calibrationSpan(i)));
     }
-    lastStableOutput[a] = map(initVal, AXIS_RAW_MIN[a], AXIS_RAW_MAX[a], 0, 1023);
   }
-  lastTrimAvg = axisSums[TRIM_AXIS_INDEX] / filterWindowSize;
+  storeCalibration();
 }
 
 // -----------------------------------------------------------------------------
-// Read Button States from MCP23017 Expanders
+// I/O Expanders (MCP23017) — 16 Buttons per Chip
 // -----------------------------------------------------------------------------
-void readButtons()
+// Up to eight MCP23017s share the bus, strapped (A2..A0) to consecutive
+// addresses from EXPANDER_BASE_ADDRESS. Chip n supplies buttons 16n..16n+15
+// and is read as one burst, so a scan costs one I2C transaction per chip and
+// the HID descriptor carries 16 buttons per chip (up to 128),
+// e.g. build_flags = -DEXPANDER_COUNT=4 for 64 buttons.
+#ifndef EXPANDER_COUNT
+#define EXPANDER_COUNT 2
+#endif
+static_assert(EXPANDER_COUNT >= 1 && EXPANDER_COUNT <= 8, "the MCP23017 has eight bus addresses");
+
+const uint8_t EXPANDER_BASE_ADDRESS = 0x20;
+const uint8_t NUM_BUTTONS = 16 * EXPANDER_COUNT;
+const uint8_t BUTTON_WORDS = (NUM_BUTTONS + 31) / 32; // 32-bit words, two chips each
+
+Adafruit_MCP23X17 expanders[EXPANDER_COUNT];
+
+// Optional interrupt-on-change: every expander drives mirrored, open-drain INT
+// outputs wired together to one Leonardo external-interrupt pin (7 = INT6),
+// and the buttons are only read over I2C after that line falls. Leave at -1
+// to poll every button scan, e.g. build_flags = -DEXPANDER_INT_PIN=7
+#ifndef EXPANDER_INT_PIN
+#define EXPANDER_INT_PIN -1
+#endif
+
+// With the interrupt line in use, still re-read this often in case an edge
+// was missed (e.g. a glitch on a long cable run)
+const unsigned long BUTTON_FALLBACK_POLL_US = 50000;
+
+// Buttons are sampled once per DEBOUNCE_SAMPLE_US and a change is accepted
+// after four identical samples in a row, i.e. an integration time of 3-4
+// sample intervals. Raise it for noisy switches, e.g. -DDEBOUNCE_SAMPLE_US=2000
+#ifndef DEBOUNCE_SAMPLE_US
+#define DEBOUNCE_SAMPLE_US 1000
+#endif
+
+volatile bool expanderChanged = true; // set by the INT line; true forces the first read
+volatile unsigned long expanderEventUs = 0;
+
+void onExpanderInterrupt()
+{
+  if (!expanderChanged)
+  {
+    expanderEventUs = micros();
+  }
+  expanderChanged = true;
+}
+
+// Asks for a button read outside the ISR, timed from now unless an INT edge
+// is already waiting with an earlier time
+void requestButtonRead()
 {
-  for (int i = 0; i < 16; i++)
+  noInterrupts();
+  if (!expanderChanged)
   {
-    Joystick.setButton(i, !mcp1.digitalRead(i));
-    Joystick.setButton(i + 16, !mcp2.digitalRead(i));
+    expanderEventUs = micros();
+    expanderChanged = true;
   }
+  interrupts();
 }
 
 // -----------------------------------------------------------------------------
-// Return Smoothed and Mapped Value for a Given Axis
+// Joystick HID Interface
+// -----------------------------------------------------------------------------
+// Axis usages follow AXIS_TABLE, so a variant table only declares what it
+// uses. No hat switches are wired, so none are declared.
+//
+// By default one report carries the buttons and axes. Build with
+// -DQUADRANT_SPLIT_REPORTS to move the buttons into their own report
+// (BUTTON_REPORT_ID): axis movement then resends only the small axis report
+// and the buttons report goes out only when a button changes. Each report ID
+// is its own HID collection, so Windows lists two game controllers and the
+// MSFS profile must bind the buttons on the second one.
+#ifdef QUADRANT_SPLIT_REPORTS
+const bool SPLIT_REPORTS = true;
+const uint8_t AXIS_BUTTON_COUNT = 0;
+#else
+const bool SPLIT_REPORTS = false;
+const uint8_t AXIS_BUTTON_COUNT = NUM_BUTTONS;
+#endif
+
+const uint8_t AXIS_REPORT_ID = JOYSTICK_DEFAULT_REPORT_ID;
+const uint8_t BUTTON_REPORT_ID = JOYSTICK_DEFAULT_REPORT_ID + 1;
+
+Joystick_ Joystick(AXIS_REPORT_ID,
+                   JOYSTICK_TYPE_MULTI_AXIS, AXIS_BUTTON_COUNT, 0,
+                   tableUsesHid(HID_X_AXIS), tableUsesHid(HID_Y_AXIS), tableUsesHid(HID_Z_AXIS),
+                   tableUsesHid(HID_RX_AXIS), tableUsesHid(HID_RY_AXIS), tableUsesHid(HID_RZ_AXIS),
+                   false, tableUsesHid(HID_THROTTLE), false,
+                   false, false);
+
+#ifdef QUADRANT_SPLIT_REPORTS
+Joystick_ ButtonPanel(BUTTON_REPORT_ID,
+                      JOYSTICK_TYPE_GAMEPAD, NUM_BUTTONS, 0,
+                      false, false, false, false, false, false,
+                      false, false, false, false, false);
+Joystick_ &ButtonReport = ButtonPanel;
+#else
+Joystick_ &ButtonReport = Joystick;
+#endif
+
+// -----------------------------------------------------------------------------
+// I2C Bus Configuration and Error Counters
+// -----------------------------------------------------------------------------
+// The MCP23017 is rated for 1.7 MHz; 400 kHz is a safe default for the
+// ribbon runs to the button panels. Fast-mode plus (1 MHz) needs short
+// wiring and stiffer pull-ups, e.g. build_flags = -DI2C_CLOCK_HZ=1000000UL
+#ifndef I2C_CLOCK_HZ
+#define I2C_CLOCK_HZ 400000UL
+#endif
+
+const uint8_t MCP23017_GPIOA = 0x12; // GPIOB follows at 0x13 (IOCON.BANK = 0)
+const uint32_t I2C_TIMEOUT_US = 2000;
+
+struct I2cStats
+{
+  unsigned long nacks;      // address or data byte not acknowledged
+  unsigned long timeouts;   // transaction aborted by the Wire timeout
+  unsigned long errors;     // any other bus error or short read
+  unsigned long recoveries; // stuck-bus recoveries performed
+  unsigned long lastScanUs; // I2C time of the last button scan
+  unsigned long maxScanUs;
+};
+
+I2cStats i2cStats = {0, 0, 0, 0, 0, 0};
+
+void configureI2cBus()
+{
+  // Must follow begin_I2C(): Wire.begin() resets the clock to 100 kHz
+  Wire.setClock(I2C_CLOCK_HZ);
+  Wire.setWireTimeout(I2C_TIMEOUT_US, true);
+}
+
+// A slave that lost sync mid-byte can hold SDA low indefinitely. Clock SCL
+// by hand until it lets go (at most 9 bits), then issue a STOP and restart
+// the TWI peripheral.
+void recoverI2cBus()
+{
+  i2cStats.recoveries++;
+  Wire.end();
+
+  pinMode(SDA, INPUT_PULLUP);
+  pinMode(SCL, INPUT_PULLUP);
+  for (uint8_t i = 0; i < 9 && digitalRead(SDA) == LOW; i++)
+  {
+    pinMode(SCL, OUTPUT); // open-drain low
+    digitalWrite(SCL, LOW);
+    delayMicroseconds(5);
+    pinMode(SCL, INPUT_PULLUP);
+    delayMicroseconds(5);
+  }
+
+  // STOP condition: SDA rises while SCL is high
+  pinMode(SDA, OUTPUT);
+  digitalWrite(SDA, LOW);
+  delayMicroseconds(5);
+  pinMode(SDA, INPUT_PULLUP);
+  delayMicroseconds(5);
+
+  Wire.begin();
+  configureI2cBus();
+}
+
+void recordI2cError(uint8_t status)
+{
+  switch (status)
+  {
+  case 2: // address NACK
+  case 3: // data NACK
+    i2cStats.nacks++;
+    break;
+  case 5:
+    i2cStats.timeouts++;
+    break;
+  default:
+    i2cStats.errors++;
+    break;
+  }
+
+  if (status == 5 || Wire.getWireTimeoutFlag() || digitalRead(SDA) == LOW)
+  {
+    Wire.clearWireTimeoutFlag();
+    recoverI2cBus();
+  }
+}
+
+// Read GPIOA and GPIOB of one expander in a single burst (bit n = pin n).
+bool readExpanderPins(uint8_t address, uint16_t &pins)
+{
+  Wire.beginTransmission(address);
+  Wire.write(MCP23017_GPIOA);
+  uint8_t status = Wire.endTransmission(false); // repeated start
+  if (status != 0)
+  {
+    recordI2cError(status);
+    return false;
+  }
+
+  if (Wire.requestFrom(address, (uint8_t)2) != 2)
+  {
+    recordI2cError(Wire.getWireTimeoutFlag() ? 5 : 4);
+    return false;
+  }
+
+  uint8_t portA = Wire.read();
+  uint8_t portB = Wire.read();
+  pins = ((uint16_t)portB << 8) | portA;
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Input Record and Replay (tools/quadrant_capture.py)
 // -----------------------------------------------------------------------------
-int getSmoothedAxis(int axisIndex, int &rawOut, int &averageOut)
+// Record: every raw sample the pipeline consumes (each ADC sample as its axis
+// filter takes it, each button word the debouncer sees that differs from the
+// last one) is queued as an event and streamed on the serial port:
+//   0xA5 0x5B seq source t0 t1 t2 t3 v0 v1 v2 v3 sum1 sum2   (14 bytes)
+// source is the axis index, or RECORD_BUTTONS + button word; t is micros()
+// of the scan that consumed the sample; little-endian, sums over seq..v3 as
+// in the telemetry frame. Frames are only written whole, so they never
+// interleave with command responses. Events that find the queue full are
+// dropped and show up as gaps in seq.
+//
+// Replay: stops the ADC sampler and the expander reads and takes samples from
+// CMD_REPLAY_SAMPLE frames instead (see Binary Command Channel). They enter
+// the same ADC rings and debouncer, so everything downstream runs unchanged;
+// recording during a replay shows exactly what the pipeline consumed.
+const uint8_t RECORD_SYNC_1 = 0x5B;
+const uint8_t RECORD_FRAME_SIZE = 14;
+const uint8_t RECORD_BUTTONS = 0x80; // + button word
+const uint8_t RECORD_QUEUE_SIZE = 16; // power of two
+
+struct RecordEvent
 {
-  rawOut = analogRead(axisPins[axisIndex]);
+  uint8_t seq;
+  uint8_t source;
+  uint32_t us;
+  uint32_t value;
+};
 
-  axisSums[axisIndex] -= axisBuffers[axisIndex][axisIndices[axisIndex]];
-  axisBuffers[axisIndex][axisIndices[axisIndex]] = rawOut;
-  axisSums[axisIndex] += rawOut;
-  axisIndices[axisIndex] = (axisIndices[axisIndex] + 1) % filterWindowSize;
+bool recording = false;
+bool replaying = false;
+RecordEvent recordQueue[RECORD_QUEUE_SIZE];
+uint8_t recordHead = 0;
+uint8_t recordTail = 0;
+uint8_t recordSeq = 0;
+unsigned long recordEventsDropped = 0;
+bool recordAllButtons = false;          // next button scan records every word
+uint32_t recordedButtons[BUTTON_WORDS]; // last button words recorded
+uint32_t replayButtons[BUTTON_WORDS];   // button words the replay holds down
+bool replayChanged = false;             // replayButtons changed since the last scan
+unsigned long replayEventUs = 0;        // when the frame carrying that change arrived
 
-  averageOut = axisSums[axisIndex] / filterWindowSize;
+// Replayed words are timed from the frame that carried them, never from an INT
+// edge the real expanders left pending
+inline void requestReplayRead()
+{
+  if (!replayChanged)
+  {
+    replayEventUs = micros();
+    replayChanged = true;
+  }
+}
 
-  int mapped = map(averageOut,
-                   AXIS_RAW_MIN[axisIndex], AXIS_RAW_MAX[axisIndex],
-                   0, 1023);
-  return constrain(mapped, 0, 1023);
+inline void recordEvent(uint8_t source, uint32_t us, uint32_t value)
+{
+  if (!recording)
+  {
+    return;
+  }
+  uint8_t seq = recordSeq++;
+  if ((uint8_t)(recordHead - recordTail) >= RECORD_QUEUE_SIZE)
+  {
+    recordEventsDropped++;
+    return;
+  }
+  RecordEvent &event = recordQueue[recordHead & (RECORD_QUEUE_SIZE - 1)];
+  event.seq = seq;
+  event.source = source;
+  event.us = us;
+  event.value = value;
+  recordHead++;
 }
 
 // -----------------------------------------------------------------------------
-// Read and Transmit Axis Values (Throttle 1–6 Only)
+// Background ADC Sampling (conversion-complete ISR)
 // -----------------------------------------------------------------------------
-void readAxes()
+// The ADC runs back to back: each conversion-complete interrupt stores its
+// result in that axis' ring, selects the next pin and starts the next
+// conversion. The main loop only drains the rings, so nothing ever busy-waits
+// on a conversion.
+//
+// Each channel is converted 1 + 4^ADC_OVERSAMPLE_BITS times in a row: the
+// first result after a mux change is discarded, the rest are summed and
+// decimated by 2^ADC_OVERSAMPLE_BITS, which gains ADC_OVERSAMPLE_BITS bits
+// of resolution from the pots' own noise. With 16x at the /64 prescaler
+// (~19k conversions/s) each of seven axes gets ~160 12-bit samples/s.
+const uint8_t ADC_RING_SIZE = 8; // power of two
+
+volatile uint16_t adcRing[NUM_AXES][ADC_RING_SIZE];
+volatile uint8_t adcHead[NUM_AXES] = {0}; // advanced by the ISR only
+uint8_t adcTail[NUM_AXES] = {0};          // advanced by loop() only
+uint8_t adcChannels[NUM_AXES];
+volatile uint8_t adcCurrentAxis = 0;
+uint16_t adcAccumulator = 0;
+uint8_t adcConversions = 0; // 0 = settling conversion after a mux change
+unsigned long adcOverruns = 0; // samples lost because loop() fell behind
+
+// Idle wake (see Idle Scan Rate): while armed, the ISR compares each sample
+// with where its axis rested when the scan went idle, so the first real
+// movement is seen at the sampling rate instead of the idle scan rate.
+bool scanIdle = false;
+volatile bool adcWakeArmed = false;
+volatile bool adcWake = false;
+volatile uint16_t adcWakeAnchor[NUM_AXES];
+volatile uint16_t adcWakeCounts = 0; // only written while disarmed; volatile keeps that order
+
+void selectAdcChannel(uint8_t channel)
 {
-  for (int i = 0; i < 6; i++)
+  // Same register setup as analogRead(): AVcc reference, MUX5 for ADC8+
+  ADCSRB = (ADCSRB & ~(1 << MUX5)) | (((channel >> 3) & 0x01) << MUX5);
+  ADMUX = (1 << REFS0) | (channel & 0x07);
+}
+
+const uint8_t ADC_OVERSAMPLE_COUNT = 1 << (2 * ADC_OVERSAMPLE_BITS);
+
+ISR(ADC_vect)
+{
+  uint16_t result = ADC;
+  if (adcConversions++ == 0)
   {
-    int raw, avg;
-    int mapped = getSmoothedAxis(i, raw, avg);
+    ADCSRA |= (1 << ADSC);
+    return;
+  }
+  adcAccumulator += result;
+  if (adcConversions <= ADC_OVERSAMPLE_COUNT)
+  {
+    ADCSRA |= (1 << ADSC);
+    return;
+  }
 
-    // Handle trim axis separately for slow accumulation
-    if (i == TRIM_AXIS_INDEX)
+  uint8_t axis = adcCurrentAxis;
+  uint8_t head = adcHead[axis];
+  uint16_t sample = adcAccumulator >> ADC_OVERSAMPLE_BITS;
+  adcRing[axis][head & (ADC_RING_SIZE - 1)] = sample;
+  adcHead[axis] = head + 1;
+  if (adcWakeArmed)
+  {
+    uint16_t anchor = adcWakeAnchor[axis];
+    if ((sample > anchor ? sample - anchor : anchor - sample) > adcWakeCounts)
     {
-      float delta = avg - lastTrimAvg;
-      lastTrimAvg = avg;
-      accumulatedTrim += delta * TRIM_INCREMENT_SCALE;
-      accumulatedTrim = constrain(accumulatedTrim, 0, 1023);
-      Joystick.setZAxis((int)accumulatedTrim);
-      continue;
+      adcWake = true;
+      adcWakeArmed = false;
     }
+  }
+  adcAccumulator = 0;
+  adcConversions = 0;
+
+  axis = (axis + 1 == NUM_AXES) ? 0 : axis + 1;
+  adcCurrentAxis = axis;
+  selectAdcChannel(adcChannels[axis]);
+  ADCSRA |= (1 << ADSC);
+}
 
-    int stable = applyDeadband(i, mapped);
+// analogRead() must not be used once this is running; adcChannels[] has to
+// be filled in first (see PrimeAxis).
+void startAdcSampling()
+{
+  adcCurrentAxis = 0;
+  adcAccumulator = 0;
+  adcConversions = 0;
+  selectAdcChannel(adcChannels[0]);
+  // /64 (250 kHz) when oversampling, the core's /128 otherwise
+  ADCSRA = (1 << ADEN) | (1 << ADIE) | (1 << ADSC) |
+           (1 << ADPS2) | (1 << ADPS1) | (ADC_OVERSAMPLE_BITS ? 0 : (1 << ADPS0));
+}
+
+// The rings as the pipeline's AxisSource (lib/QuadrantPipeline/InputSource.h).
+// If loop() fell so far behind that a ring wrapped, the oldest samples are
+// skipped. Every sample taken is also recorded.
+struct AdcRingSource
+{
+  inline bool take(uint8_t axis, int &sample)
+  {
+    uint8_t head = adcHead[axis];
+    uint8_t tail = adcTail[axis];
+    if (head == tail)
+    {
+      return false;
+    }
 
-    switch (i)
+    // Never read the slot the ISR may be writing next
+    if ((uint8_t)(head - tail) > ADC_RING_SIZE - 1)
     {
-    case 0:
-      Joystick.setXAxis(stable);
-      break;
-    case 1:
-      Joystick.setYAxis(stable);
-      break;
-    case 3:
-      Joystick.setRxAxis(stable);
-      break;
-    case 4:
-      Joystick.setRyAxis(stable);
-      break;
-    case 5:
-      Joystick.setRzAxis(stable);
-      break;
+      adcOverruns++;
+      tail = head - (ADC_RING_SIZE - 1);
     }
+    sample = adcRing[axis][tail & (ADC_RING_SIZE - 1)];
+    adcTail[axis] = tail + 1;
+    recordEvent(axis, axisScanUs, sample);
+    return true;
   }
+};
+
+AdcRingSource adcRingSource;
+
+// Feed every sample the ISR produced since the last call into the axis
+// filter. Returns false if no new sample arrived.
+template <uint8_t I>
+bool drainAdcRing(int &latestOut)
+{
+  return drainAxis(adcRingSource, I, AxisSmoothing<I>::state, params.filter, latestOut);
+}
+
+// Replay stands in for the ISR: the ADC interrupt is off, so loop() owns
+// the ring heads
+void stopAdcSampling()
+{
+  ADCSRA &= ~(1 << ADIE);
+}
+
+void replayAxisSample(uint8_t axis, uint16_t sample)
+{
+  uint8_t head = adcHead[axis];
+  adcRing[axis][head & (ADC_RING_SIZE - 1)] = sample;
+  adcHead[axis] = head + 1;
 }
 
 // -----------------------------------------------------------------------------
-// Debug Output for Serial Monitor — Live Table View
+// Adaptive Deadband & Virtual Trim Accumulation
 // -----------------------------------------------------------------------------
-void printAxisDebug()
+int lastStableOutput[NUM_AXES] = {0};
+
+template <uint8_t I>
+inline int applyDeadband(int currentMapped)
+{
+  return applyDeadband(currentMapped, lastStableOutput[I], params.deadband[I]);
+}
+
+// AxisOutput<I> turns a filtered sample into the value reported for axis I.
+template <uint8_t I, AxisMode M = AXIS_TABLE[I].mode>
+struct AxisOutput;
+
+template <uint8_t I>
+struct AxisOutput<I, AXIS_ABSOLUTE>
 {
-  Serial.print("\033[2J\033[H");
-  Serial.println("─────────────────────────────────────────────────────────────────────────────");
-  Serial.println("  Axis         Raw    Smoothed    Mapped     ΔMapped");
-  Serial.println("─────────────────────────────────────────────────────────────────────────────");
+  static void prime(int average)
+  {
+    lastStableOutput[I] = mapAxis<I>(average);
+  }
+
+  static inline int update(const AxisSample &sample)
+  {
+    return applyDeadband<I>(sample.mapped);
+  }
+};
+
+// Virtual trim: the pot drives a TrimEngine (pipeline library) at the full
+// scan rate. The accumulator is saved to EEPROM once the wheel has rested
+// for TRIM_SAVE_IDLE_MS, a byte at a time, and restored at boot.
+//
+// Trim is touched all flight, so each trim axis rotates its saves across
+// TRIM_RECORD_SLOTS records, each stamped with a sequence number one past
+// the last; boot restores the newest record whose CRC checks. That spreads
+// the wear over the slots, and a save cut short by power-off only loses
+// itself: the record before it is still intact.
+const unsigned long TRIM_SAVE_IDLE_MS = 10000;
+const uint16_t TRIM_RECORD_MAGIC = 0x5154; // "TQ"
+const uint8_t TRIM_RECORD_SLOTS = 8;
+
+struct TrimRecord
+{
+  uint16_t magic;
+  uint8_t seq; // one past the previous save, wrapping
+  int32_t value;
+  uint16_t crc; // CRC-16 over every byte before it
+};
+
+constexpr uint8_t trimAxesBefore(uint8_t i)
+{
+  return i == 0 ? 0 : trimAxesBefore(i - 1) + (AXIS_TABLE[i - 1].mode == AXIS_VIRTUAL_TRIM);
+}
+
+// TRIM_RECORD_SLOTS records per trim axis, after the calibration block
+const int TRIM_EEPROM_ADDRESS = CALIBRATION_EEPROM_ADDRESS + sizeof(CalibrationBlock);
+const int TRIM_EEPROM_SIZE = trimAxesBefore(NUM_AXES) * TRIM_RECORD_SLOTS * sizeof(TrimRecord);
+
+template <uint8_t I>
+struct AxisOutput<I, AXIS_VIRTUAL_TRIM>
+{
+  static constexpr int span = clampAxisSpan((long)(AXIS_TABLE[I].rawMax - AXIS_TABLE[I].rawMin) << ADC_OVERSAMPLE_BITS);
+  static constexpr int address = TRIM_EEPROM_ADDRESS + trimAxesBefore(I) * TRIM_RECORD_SLOTS * sizeof(TrimRecord);
+
+  static TrimEngine engine;
+  static unsigned long movedMs;   // last time the accumulator changed
+  static int32_t savedTrim;       // value in EEPROM (or being written)
+  static TrimRecord record;       // being written while saveNext < sizeof(record)
+  static uint8_t saveNext;
+  static uint8_t slot;            // of the newest record (the one being written)
+
+  static void prime(int average)
+  {
+    int32_t value = TRIM_Q_MID; // start at the midpoint
+    bool found = false;
+    for (uint8_t i = 0; i < TRIM_RECORD_SLOTS; i++)
+    {
+      TrimRecord stored;
+      EEPROM.get(address + i * sizeof(TrimRecord), stored);
+      if (stored.magic != TRIM_RECORD_MAGIC || stored.crc != eepromCrc(&stored, offsetof(TrimRecord, crc)))
+      {
+        continue;
+      }
+      if (!found || (int8_t)(stored.seq - record.seq) > 0)
+      {
+        found = true;
+        record.seq = stored.seq;
+        slot = i;
+        value = stored.value;
+      }
+    }
+    if (!found)
+    {
+      record.seq = 0;
+      slot = TRIM_RECORD_SLOTS - 1; // the first save goes to slot 0
+    }
+    engine.prime(average, micros(), value);
+    savedTrim = engine.accumulated;
+  }
+
+  static inline int update(const AxisSample &sample)
+  {
+    if (engine.update(sample.raw, axisScanUs, span, params.trim))
+    {
+      movedMs = millis();
+    }
+    persist();
+    return engine.output();
+  }
 
-  for (int i = 0; i < 6; i++)
+  static inline void persist()
   {
-    int raw, avg;
-    int mapped = getSmoothedAxis(i, raw, avg);
-    int delta = abs(mapped - lastStableOutput[i]);
-    int stable = applyDeadband(i, mapped);
+    if (saveNext < sizeof(TrimRecord))
+    {
+      trickleWriteEeprom(address + slot * sizeof(TrimRecord), (const uint8_t *)&record, sizeof(TrimRecord),
+                         saveNext);
+    }
+    else if (engine.accumulated != savedTrim && millis() - movedMs >= TRIM_SAVE_IDLE_MS)
+    {
+      slot = (slot + 1 == TRIM_RECORD_SLOTS) ? 0 : slot + 1;
+      record.magic = TRIM_RECORD_MAGIC;
+      record.seq++;
+      record.value = engine.accumulated;
+      record.crc = eepromCrc(&record, offsetof(TrimRecord, crc));
+      savedTrim = engine.accumulated;
+      saveNext = 0;
+    }
+  }
+};
 
-    Serial.print("  ");
-    Serial.print(axisLabels[i]);
-    Serial.print("  |  ");
-    Serial.print(raw);
-    Serial.print("  |    ");
-    Serial.print(avg);
-    Serial.print("     |   ");
-    Serial.print(mapped);
-    Serial.print("     |     ");
-    Serial.println(delta);
+template <uint8_t I>
+TrimEngine AxisOutput<I, AXIS_VIRTUAL_TRIM>::engine;
+template <uint8_t I>
+unsigned long AxisOutput<I, AXIS_VIRTUAL_TRIM>::movedMs = 0;
+template <uint8_t I>
+int32_t AxisOutput<I, AXIS_VIRTUAL_TRIM>::savedTrim = 0;
+template <uint8_t I>
+TrimRecord AxisOutput<I, AXIS_VIRTUAL_TRIM>::record;
+template <uint8_t I>
+uint8_t AxisOutput<I, AXIS_VIRTUAL_TRIM>::saveNext = sizeof(TrimRecord);
+template <uint8_t I>
+uint8_t AxisOutput<I, AXIS_VIRTUAL_TRIM>::slot = 0;
+
+// -----------------------------------------------------------------------------
+// Loop-Time and Latency Instrumentation
+// -----------------------------------------------------------------------------
+// Cheap always-on counters, printed on demand with 's' and cleared with 'r'.
+// Input-to-report latency runs from the first input change since the last
+// report (the expander INT edge in interrupt mode, otherwise the scan that
+// saw it) to the sendState() carrying it; USB and host time are not included.
+struct StageTiming
+{
+  unsigned long lastUs;
+  unsigned long minUs;
+  unsigned long maxUs;
+  unsigned long totalUs;
+  unsigned long count;
+};
+
+StageTiming buttonTiming, axisTiming, hidTiming, telemetryTiming, loopPeriod;
+unsigned long lastLoopUs = 0;
+
+unsigned long hidReportsSent = 0;
+unsigned long hidReportsSuppressed = 0;
+unsigned long hidKeepalivesSent = 0;
+unsigned long hidAxisUpdatesDeferred = 0;
+
+const uint8_t LATENCY_BUCKETS = 8; // [0] < 125 us, doubling, [7] >= 8 ms
+unsigned long latencyHistogram[LATENCY_BUCKETS];
+bool inputPending = false;
+unsigned long pendingInputUs = 0;
+unsigned long lastInputMs = 0; // for the idle timeout
+
+void recordTiming(StageTiming &timing, unsigned long us)
+{
+  timing.lastUs = us;
+  if (us < timing.minUs)
+    timing.minUs = us;
+  if (us > timing.maxUs)
+    timing.maxUs = us;
+  timing.totalUs += us;
+  timing.count++;
+}
+
+// Records the time since startUs and returns now, so stages can be chained
+// with one micros() call between them.
+unsigned long recordStage(StageTiming &timing, unsigned long startUs)
+{
+  unsigned long now = micros();
+  recordTiming(timing, now - startUs);
+  return now;
+}
+
+void resetTiming(StageTiming &timing)
+{
+  timing.lastUs = 0;
+  timing.minUs = 0xFFFFFFFFUL;
+  timing.maxUs = 0;
+  timing.totalUs = 0;
+  timing.count = 0;
+}
+
+void resetInstrumentation()
+{
+  resetTiming(buttonTiming);
+  resetTiming(axisTiming);
+  resetTiming(hidTiming);
+  resetTiming(telemetryTiming);
+  resetTiming(loopPeriod);
+  hidReportsSent = 0;
+  hidReportsSuppressed = 0;
+  hidKeepalivesSent = 0;
+  hidAxisUpdatesDeferred = 0;
+  memset(latencyHistogram, 0, sizeof(latencyHistogram));
+}
+
+void noteInputChange(unsigned long atUs)
+{
+  if (!inputPending)
+  {
+    inputPending = true;
+    pendingInputUs = atUs;
   }
+  lastInputMs = millis();
+}
 
-  Serial.println("─────────────────────────────────────────────────────────────────────────────");
+void recordReportLatency(unsigned long sentUs)
+{
+  unsigned long latency = sentUs - pendingInputUs;
+  uint8_t bucket = 0;
+  for (unsigned long limit = 125; bucket < LATENCY_BUCKETS - 1 && latency >= limit; limit <<= 1)
+  {
+    bucket++;
+  }
+  latencyHistogram[bucket]++;
+  inputPending = false;
 }
 
 // -----------------------------------------------------------------------------
-// Main Loop — Read Inputs and Print Debug Output
+// HID Frame Staging — one report per scan, sent only when it changes
 // -----------------------------------------------------------------------------
-void loop()
+// Change detection sits on top of the per-axis deadband in AXIS_TABLE:
+// - Frames identical to the last report are not sent.
+// - An unchanged frame is still re-sent every HID_KEEPALIVE_MS so the host
+//   sees the device as live (0 disables the keepalive); while the scan is
+//   idle the interval is params.idleKeepaliveMs instead.
+// - Each axis reports at most once per AXIS_MIN_REPORT_INTERVAL_US. The first
+//   change after a quiet interval goes out immediately; further changes
+//   inside the interval are held and sent when it expires, so a moving lever
+//   reports its latest position at the capped rate. Buttons are never capped.
+#ifndef HID_KEEPALIVE_MS
+#define HID_KEEPALIVE_MS 500
+#endif
+#ifndef AXIS_MIN_REPORT_INTERVAL_US
+#define AXIS_MIN_REPORT_INTERVAL_US 4000 // 250 Hz per axis
+#endif
+
+struct HidFrame
 {
-  readButtons();
-  readAxes();
-  printAxisDebug();
-  delay(100);
+  uint32_t buttons[BUTTON_WORDS]; // bit n of word w set = button 32w + n pressed
+  int axes[NUM_AXES];   // indexed like AXIS_TABLE
+};
+
+HidFrame stagedFrame = {{0}, {0}};
+HidFrame sentFrame = {{0}, {0}};
+bool hidFrameSent = false; // false until the host has been sent a full report
+bool firstReportSent = false; // false until a report has reached a configured host
+unsigned long bootToFirstReportUs = 0; // micros() since reset at that point
+bool usbConfigured = false; // as of the last commit
+unsigned long lastReportUs = 0;
+unsigned long axisReportedUs[NUM_AXES]; // when each axis last changed in a report
+
+void stageButton(uint8_t button, bool pressed)
+{
+  uint32_t mask = 1UL << (button & 31);
+  if (pressed)
+    stagedFrame.buttons[button >> 5] |= mask;
+  else
+    stagedFrame.buttons[button >> 5] &= ~mask;
+}
+
+template <HidAxis T>
+void setHidAxis(int value);
+
+template <>
+inline void setHidAxis<HID_X_AXIS>(int value) { Joystick.setXAxis(value); }
+template <>
+inline void setHidAxis<HID_Y_AXIS>(int value) { Joystick.setYAxis(value); }
+template <>
+inline void setHidAxis<HID_Z_AXIS>(int value) { Joystick.setZAxis(value); }
+template <>
+inline void setHidAxis<HID_RX_AXIS>(int value) { Joystick.setRxAxis(value); }
+template <>
+inline void setHidAxis<HID_RY_AXIS>(int value) { Joystick.setRyAxis(value); }
+template <>
+inline void setHidAxis<HID_RZ_AXIS>(int value) { Joystick.setRzAxis(value); }
+template <>
+inline void setHidAxis<HID_THROTTLE>(int value) { Joystick.setThrottle(value); }
+
+template <HidAxis T>
+void setHidAxisRange(int32_t maximum);
+
+template <>
+inline void setHidAxisRange<HID_X_AXIS>(int32_t maximum) { Joystick.setXAxisRange(0, maximum); }
+template <>
+inline void setHidAxisRange<HID_Y_AXIS>(int32_t maximum) { Joystick.setYAxisRange(0, maximum); }
+template <>
+inline void setHidAxisRange<HID_Z_AXIS>(int32_t maximum) { Joystick.setZAxisRange(0, maximum); }
+template <>
+inline void setHidAxisRange<HID_RX_AXIS>(int32_t maximum) { Joystick.setRxAxisRange(0, maximum); }
+template <>
+inline void setHidAxisRange<HID_RY_AXIS>(int32_t maximum) { Joystick.setRyAxisRange(0, maximum); }
+template <>
+inline void setHidAxisRange<HID_RZ_AXIS>(int32_t maximum) { Joystick.setRzAxisRange(0, maximum); }
+template <>
+inline void setHidAxisRange<HID_THROTTLE>(int32_t maximum) { Joystick.setThrottleRange(0, maximum); }
+
+// The library scales 0..AXIS_OUTPUT_MAX onto the report's full 16-bit field
+template <uint8_t I>
+struct SetAxisRange
+{
+  static void run()
+  {
+    setHidAxisRange<AXIS_TABLE[I].hid>(AXIS_OUTPUT_MAX);
+  }
+};
+
+// Copy a staged axis into the outgoing frame unless its rate cap holds it back
+template <uint8_t I>
+struct GateAxis
+{
+  static inline void run(HidFrame &out, unsigned long now)
+  {
+    if (!hidFrameSent || stagedFrame.axes[I] == sentFrame.axes[I])
+    {
+      out.axes[I] = stagedFrame.axes[I];
+      return;
+    }
+    if (now - axisReportedUs[I] < params.axisReportIntervalUs)
+    {
+      out.axes[I] = sentFrame.axes[I];
+      hidAxisUpdatesDeferred++;
+      return;
+    }
+    out.axes[I] = stagedFrame.axes[I];
+    axisReportedUs[I] = now;
+  }
+};
+
+template <uint8_t I>
+struct CommitAxis
+{
+  static inline void run(const HidFrame &out)
+  {
+    if (!hidFrameSent || out.axes[I] != sentFrame.axes[I])
+    {
+      setHidAxis<AXIS_TABLE[I].hid>(out.axes[I]);
+    }
+  }
+};
+
+// Push only the fields that differ from the last report into the Joystick
+// state, then send a single report (with split reports, only the reports
+// whose fields changed). Identical frames are not sent at all unless the
+// keepalive is due, which resends every report.
+//
+// The core drops any report sent before the host has configured the device,
+// so nothing is sent (or counted as sent) until it has; each time it becomes
+// configured again (first enumeration, host reboot, hub replug) the next
+// commit resends every field, as the host holds no state from before.
+void sendReport(Joystick_ &report)
+{
+  report.sendState();
+  hidReportsSent++;
+}
+
+void commitHidFrame()
+{
+  if (!USBDevice.configured())
+  {
+    usbConfigured = false;
+    return;
+  }
+  if (!usbConfigured)
+  {
+    usbConfigured = true;
+    hidFrameSent = false;
+  }
+  unsigned long now = micros();
+
+  HidFrame out;
+  memcpy(out.buttons, stagedFrame.buttons, sizeof(out.buttons));
+  UnrollAxes<GateAxis>::run(out, now);
+
+  bool buttonsChanged = !hidFrameSent || memcmp(out.buttons, sentFrame.buttons, sizeof(out.buttons)) != 0;
+  bool axesChanged = !hidFrameSent || memcmp(out.axes, sentFrame.axes, sizeof(out.axes)) != 0;
+  if (!buttonsChanged && !axesChanged)
+  {
+    uint16_t keepaliveMs = scanIdle ? params.idleKeepaliveMs : params.keepaliveMs;
+    bool keepaliveDue = keepaliveMs > 0 && now - lastReportUs >= keepaliveMs * 1000UL;
+    if (memcmp(&stagedFrame, &sentFrame, sizeof(HidFrame)) == 0)
+    {
+      inputPending = false; // changed and changed back before it was sent
+    }
+    if (!keepaliveDue)
+    {
+      hidReportsSuppressed++;
+      return;
+    }
+    hidKeepalivesSent++;
+    buttonsChanged = axesChanged = true;
+  }
+
+  for (uint8_t w = 0; w < BUTTON_WORDS; w++)
+  {
+    uint32_t changed = hidFrameSent ? (out.buttons[w] ^ sentFrame.buttons[w]) : 0xFFFFFFFFUL;
+    while (changed)
+    {
+      uint8_t b = 32 * w + __builtin_ctzl(changed);
+      changed &= changed - 1;
+      if (b < NUM_BUTTONS)
+      {
+        ButtonReport.setButton(b, (out.buttons[w] >> (b & 31)) & 1);
+      }
+    }
+  }
+
+  UnrollAxes<CommitAxis>::run(out);
+
+  if (!SPLIT_REPORTS || axesChanged)
+  {
+    sendReport(Joystick);
+  }
+  if (SPLIT_REPORTS && buttonsChanged)
+  {
+    sendReport(ButtonReport);
+  }
+  bool held = memcmp(&out, &stagedFrame, sizeof(HidFrame)) != 0;
+  sentFrame = out;
+  lastReportUs = micros();
+  if (inputPending && !held)
+  {
+    recordReportLatency(lastReportUs);
+  }
+  if (!firstReportSent)
+  {
+    bootToFirstReportUs = lastReportUs;
+    firstReportSent = true;
+  }
+  hidFrameSent = true;
+}
+
+// -----------------------------------------------------------------------------
+// Fixed-Rate Scan Scheduler
+// -----------------------------------------------------------------------------
+// Each task is released on a fixed micros() grid (nextDue += period), so its
+// rate does not drift with how much work a tick does. A task that falls a
+// whole period behind counts an overrun and re-aligns to now instead of
+// bursting to catch up.
+const unsigned long AXIS_SCAN_PERIOD_US = 1000;   // 1 kHz
+const unsigned long BUTTON_SCAN_PERIOD_US = DEBOUNCE_SAMPLE_US; // one debounce sample per scan
+
+struct ScanTask
+{
+  unsigned long periodUs;
+  unsigned long nextDueUs;
+  unsigned long overruns;
+};
+
+ScanTask axisTask = {AXIS_SCAN_PERIOD_US, 0, 0};
+ScanTask buttonTask = {BUTTON_SCAN_PERIOD_US, 0, 0};
+
+void startTask(ScanTask &task, unsigned long now)
+{
+  task.nextDueUs = now;
+  task.overruns = 0;
+}
+
+bool taskDue(ScanTask &task, unsigned long now)
+{
+  if ((long)(now - task.nextDueUs) < 0)
+  {
+    return false;
+  }
+
+  task.nextDueUs += task.periodUs;
+  if ((long)(now - task.nextDueUs) >= 0)
+  {
+    task.overruns++;
+    task.nextDueUs = now + task.periodUs;
+  }
+  return true;
+}
+
+// Seed each axis' filter from a short burst of real readings (one full
+// window) rather than one reading copied into every slot, then seed the
+// output stage from the result and record the ADC channel for the sampler.
+template <uint8_t I>
+struct PrimeAxis
+{
+  static void run()
+  {
+    int sample = analogRead(AXIS_TABLE[I].pin) << ADC_OVERSAMPLE_BITS;
+    AxisSmoothing<I>::prime(sample);
+    for (int i = 1; i < filterWindowSize; i++)
+    {
+      sample = analogRead(AXIS_TABLE[I].pin) << ADC_OVERSAMPLE_BITS;
+      AxisSmoothing<I>::push(sample);
+    }
+    AxisOutput<I>::prime(AxisSmoothing<I>::average());
+    axisSamples[I].raw = sample;
+    adcChannels[I] = analogPinToChannel(AXIS_TABLE[I].pin - A0);
+  }
+};
+
+// -----------------------------------------------------------------------------
+// Read Button States from MCP23017 Expanders
+// -----------------------------------------------------------------------------
+// Each expander is read as one GPIOA/GPIOB burst (bit n = pin n), in address
+// order, so a full scan costs one I2C transaction per chip. Buttons are
+// active LOW. A chip whose read fails keeps its buttons as they were. In
+// interrupt mode the reads are skipped until the INT line reports a change,
+// and keep going every scan while any button is still bouncing; reading GPIO
+// also clears the expander's pending interrupt.
+//
+// Debounce is a ButtonDebouncer (pipeline library) per word of 32 buttons:
+// a change is taken on the fourth agreeing sample. readButtons() only runs on
+// button scan ticks, also in interrupt mode (an edge just marks the next
+// tick's read as needed), so the samples stay one scan period apart and
+// contact bounce cannot pile them up faster than the integration time.
+//
+// A chip whose read failed is retried on the next tick; each further failure
+// in a row doubles the ticks it is skipped for, up to 2^EXPANDER_RETRY_MAX_SHIFT,
+// so a missing or broken expander does not keep the bus in timeouts and
+// recoveries. In interrupt mode a pending retry is its own reason to read,
+// apart from the INT line.
+const uint8_t EXPANDER_RETRY_MAX_SHIFT = 9; // 512 ticks, ~0.5 s at 1 ms scans
+
+ButtonDebouncer debouncers[BUTTON_WORDS];
+bool buttonWordValid = false;
+bool buttonsBouncing = false;
+unsigned long bounceStartUs = 0; // first sample of the change being debounced
+unsigned long lastButtonReadUs = 0;
+uint8_t expanderFailures[EXPANDER_COUNT] = {0}; // failed reads in a row
+uint16_t expanderSkipTicks[EXPANDER_COUNT] = {0}; // ticks left before the next retry
+
+void noteExpanderFailure(uint8_t chip)
+{
+  uint8_t failures = expanderFailures[chip];
+  if (failures < 255)
+  {
+    failures++;
+  }
+  expanderFailures[chip] = failures;
+  uint8_t shift = failures - 1 < EXPANDER_RETRY_MAX_SHIFT ? failures - 1 : EXPANDER_RETRY_MAX_SHIFT;
+  expanderSkipTicks[chip] = (1U << shift) - 1;
+}
+
+// Called once per button tick; bit n set = failed chip n is due for a retry
+uint8_t expanderRetriesDue()
+{
+  uint8_t due = 0;
+  for (uint8_t chip = 0; chip < EXPANDER_COUNT; chip++)
+  {
+    if (expanderFailures[chip] == 0)
+    {
+      continue;
+    }
+    if (expanderSkipTicks[chip] > 0)
+    {
+      expanderSkipTicks[chip]--;
+    }
+    else
+    {
+      due |= 1 << chip;
+    }
+  }
+  return due;
+}
+
+// The expanders as the pipeline's ButtonSource (lib/QuadrantPipeline/
+// InputSource.h). A failing chip is only retried when its back-off allows;
+// until then it reads as unreadable and holds its debounced state.
+struct ExpanderSource
+{
+  uint8_t retriesDue; // from expanderRetriesDue(), for this scan
+
+  inline bool read(uint8_t chip, uint16_t &pressed)
+  {
+    if (expanderFailures[chip] != 0 && !((retriesDue >> chip) & 1))
+    {
+      return false;
+    }
+    uint16_t pins;
+    if (!readExpanderPins(EXPANDER_BASE_ADDRESS + chip, pins))
+    {
+      noteExpanderFailure(chip);
+      return false;
+    }
+    pressed = ~pins; // inputs are pulled up, pressed reads low
+    expanderFailures[chip] = 0;
+    return true;
+  }
+};
+
+void readButtons()
+{
+  unsigned long inputUs = micros();
+  uint8_t retriesDue = expanderRetriesDue();
+  if (EXPANDER_INT_PIN >= 0)
+  {
+    unsigned long now = inputUs;
+    if (!expanderChanged && !replayChanged && !retriesDue && !buttonsBouncing &&
+        now - lastButtonReadUs < BUTTON_FALLBACK_POLL_US)
+    {
+      return;
+    }
+    noInterrupts();
+    if (expanderChanged)
+    {
+      inputUs = expanderEventUs;
+    }
+    expanderChanged = false; // cleared before reading so a new edge is kept
+    interrupts();
+    lastButtonReadUs = now;
+  }
+
+  unsigned long i2cStartUs = micros();
+  uint32_t sample[BUTTON_WORDS] = {0};
+  if (replaying)
+  {
+    inputUs = replayChanged ? replayEventUs : i2cStartUs;
+    memcpy(sample, replayButtons, sizeof(sample));
+  }
+  else
+  {
+    ExpanderSource source = {retriesDue};
+    sampleButtons(source, EXPANDER_COUNT, debouncers, sample);
+  }
+  replayChanged = false;
+  i2cStats.lastScanUs = micros() - i2cStartUs;
+  if (i2cStats.lastScanUs > i2cStats.maxScanUs)
+  {
+    i2cStats.maxScanUs = i2cStats.lastScanUs;
+  }
+  for (uint8_t w = 0; w < BUTTON_WORDS; w++)
+  {
+    if (recordAllButtons || sample[w] != recordedButtons[w])
+    {
+      recordedButtons[w] = sample[w];
+      recordEvent(RECORD_BUTTONS + w, inputUs, sample[w]);
+    }
+  }
+  recordAllButtons = false;
+
+  bool anyChanged = false;
+  bool bouncing = false;
+  for (uint8_t w = 0; w < BUTTON_WORDS; w++)
+  {
+    uint32_t changed;
+    if (buttonWordValid)
+    {
+      changed = debouncers[w].update(sample[w]);
+    }
+    else
+    {
+      debouncers[w].reset(sample[w]); // boot state is taken as-is
+      changed = 0xFFFFFFFFUL;
+    }
+    bouncing |= (sample[w] ^ debouncers[w].state) != 0;
+    anyChanged |= changed != 0;
+
+    while (changed)
+    {
+      uint8_t b = __builtin_ctzl(changed);
+      changed &= changed - 1;
+      stageButton(32 * w + b, (debouncers[w].state >> b) & 1);
+    }
+  }
+  buttonWordValid = true;
+
+  // Latency is measured from the first sample of a change, not from when
+  // the debouncer accepted it
+  if (anyChanged)
+  {
+    noteInputChange(buttonsBouncing ? bounceStartUs : inputUs);
+  }
+  if (bouncing && !buttonsBouncing)
+  {
+    bounceStartUs = inputUs;
+  }
+  buttonsBouncing = bouncing;
+
+  // The shared line only falls once: if another chip asserted while the
+  // line was already low, it is still low now and needs another read. That
+  // chip's edge came after this read started, so it is timed from now rather
+  // than from the edge just consumed.
+  if (EXPANDER_INT_PIN >= 0 && digitalRead(EXPANDER_INT_PIN) == LOW)
+  {
+    requestButtonRead();
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Idle Scan Rate
+// -----------------------------------------------------------------------------
+// With nothing touched for idleTimeoutMs, both scans drop to idleScanPeriodUs
+// and the keepalive to idleKeepaliveMs, which cuts the reports (and host USB
+// interrupts) of a quadrant left alone in cruise to a trickle. The ADC keeps
+// sampling at full rate: it is what notices the first movement. Any of these
+// wakes the scan on the next loop pass, and both tasks are due at once:
+// - the ADC ISR sees an axis more than idleWakeCounts from its idle position
+// - the expander INT line falls (interrupt mode)
+// - a polled button sample differs from its debounced state
+// - a deadband-passing change reaches the frame (slow drift, replay)
+#ifndef IDLE_TIMEOUT_MS
+#define IDLE_TIMEOUT_MS 0 // e.g. 30000; 0 = always scan at the full rate
+#endif
+#ifndef IDLE_SCAN_PERIOD_US
+#define IDLE_SCAN_PERIOD_US 20000 // 50 Hz
+#endif
+#ifndef IDLE_KEEPALIVE_MS
+#define IDLE_KEEPALIVE_MS 2000
+#endif
+#ifndef IDLE_WAKE_COUNTS
+#define IDLE_WAKE_COUNTS (8 << ADC_OVERSAMPLE_BITS) // 8 counts of the 10-bit ADC
+#endif
+
+unsigned long idleEntries = 0;
+
+void setScanPeriods()
+{
+  axisTask.periodUs = scanIdle ? params.idleScanPeriodUs : params.axisScanPeriodUs;
+  buttonTask.periodUs = scanIdle ? params.idleScanPeriodUs : params.buttonScanPeriodUs;
+}
+
+void enterIdle()
+{
+  scanIdle = true;
+  idleEntries++;
+  setScanPeriods();
+  adcWakeCounts = params.idleWakeCounts;
+  for (uint8_t i = 0; i < NUM_AXES; i++)
+  {
+    adcWakeAnchor[i] = axisSamples[i].raw;
+  }
+  adcWake = false;
+  adcWakeArmed = true;
+}
+
+// Both tasks are released at now, so the wake-up tick already scans at the
+// full rate. Their overrun counters are left alone.
+void exitIdle(unsigned long now)
+{
+  adcWakeArmed = false;
+  adcWake = false;
+  scanIdle = false;
+  lastInputMs = millis();
+  setScanPeriods();
+  axisTask.nextDueUs = now;
+  buttonTask.nextDueUs = now;
+}
+
+void serviceIdle(unsigned long now)
+{
+  if (scanIdle)
+  {
+    if (adcWake || (EXPANDER_INT_PIN >= 0 && expanderChanged) || buttonsBouncing ||
+        millis() - lastInputMs < params.idleTimeoutMs || params.idleTimeoutMs == 0)
+    {
+      exitIdle(now);
+    }
+  }
+  else if (params.idleTimeoutMs > 0 && !buttonsBouncing && !calibrating &&
+           millis() - lastInputMs >= params.idleTimeoutMs)
+  {
+    enterIdle();
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Return Smoothed and Mapped Value for a Given Axis
+// -----------------------------------------------------------------------------
+// rawOut keeps its previous value when the ISR has no new sample yet.
+template <uint8_t I>
+inline int getSmoothedAxis(int &rawOut, int &averageOut)
+{
+  drainAdcRing<I>(rawOut);
+
+  averageOut = AxisSmoothing<I>::average();
+  return mapAxis<I>(averageOut);
+}
+
+// -----------------------------------------------------------------------------
+// Read and Stage Axis Values
+// -----------------------------------------------------------------------------
+template <uint8_t I>
+inline void stageAxis(int value)
+{
+  if (stagedFrame.axes[I] != value)
+  {
+    stagedFrame.axes[I] = value;
+    noteInputChange(axisScanUs);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Dual-Throttle Sync
+// -----------------------------------------------------------------------------
+// Two levers set to the same position rarely read the same, so the engines
+// split by a few counts and both axes flicker on their own. With sync on
+// (syncTolerance > 0), once the two mapped positions come within
+// syncTolerance output counts they lock: both report one shared value, their
+// mean, through a single deadband. Moving them more than syncRelease apart
+// unlocks them again; the gap between the two thresholds is the hysteresis
+// that keeps a pair near the edge from chattering.
+#ifndef THROTTLE_SYNC_TOLERANCE
+#define THROTTLE_SYNC_TOLERANCE 0 // output counts, e.g. 24 (0.6%); 0 = off
+#endif
+#ifndef THROTTLE_SYNC_RELEASE
+#define THROTTLE_SYNC_RELEASE 64
+#endif
+
+const uint8_t SYNC_LEFT = 0; // Throttle L
+const uint8_t SYNC_RIGHT = 1; // Throttle R
+static_assert(SYNC_RIGHT < NUM_AXES, "throttle sync needs two axes");
+static_assert(AXIS_TABLE[SYNC_LEFT].mode == AXIS_ABSOLUTE && AXIS_TABLE[SYNC_RIGHT].mode == AXIS_ABSOLUTE,
+              "throttle sync axes must be absolute");
+
+bool throttlesLocked = false;
+unsigned long throttleSyncLocks = 0;
+
+constexpr bool isSyncAxis(uint8_t i)
+{
+  return i == SYNC_LEFT || i == SYNC_RIGHT;
+}
+
+// Runs after both axes are sampled; with sync on, it owns their output
+void syncThrottles()
+{
+  AxisSample &left = axisSamples[SYNC_LEFT];
+  AxisSample &right = axisSamples[SYNC_RIGHT];
+  int split = abs(left.mapped - right.mapped);
+  if (throttlesLocked)
+  {
+    throttlesLocked = split <= (int)max(params.syncRelease, params.syncTolerance);
+  }
+  else if (split <= (int)params.syncTolerance)
+  {
+    throttlesLocked = true;
+    throttleSyncLocks++;
+  }
+
+  if (throttlesLocked)
+  {
+    int shared = applyDeadband<SYNC_LEFT>((left.mapped + right.mapped + 1) >> 1);
+    lastStableOutput[SYNC_RIGHT] = shared;
+    left.stable = shared;
+    right.stable = shared;
+  }
+  else
+  {
+    left.stable = AxisOutput<SYNC_LEFT>::update(left);
+    right.stable = AxisOutput<SYNC_RIGHT>::update(right);
+  }
+  stageAxis<SYNC_LEFT>(left.stable);
+  stageAxis<SYNC_RIGHT>(right.stable);
+}
+
+template <uint8_t I>
+struct SampleAxis
+{
+  static inline void run()
+  {
+    AxisSample &sample = axisSamples[I];
+    sample.mapped = getSmoothedAxis<I>(sample.raw, sample.average);
+    if (isSyncAxis(I) && params.syncTolerance)
+    {
+      return; // output comes from syncThrottles()
+    }
+    sample.stable = AxisOutput<I>::update(sample);
+    stageAxis<I>(sample.stable);
+  }
+};
+
+void readAxes()
+{
+  axisScanUs = micros();
+  UnrollAxes<SampleAxis>::run();
+  if (params.syncTolerance)
+  {
+    syncThrottles();
+  }
+  else
+  {
+    throttlesLocked = false;
+  }
+  if (calibrating)
+  {
+    trackCalibration();
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Debug Output for Serial Monitor — Live Table View (non-blocking)
+// -----------------------------------------------------------------------------
+// The table is streamed piece by piece and never writes more than the CDC
+// buffer accepts, so loop() never waits on the host. A frame still unfinished
+// when the next one is due is dropped; every frame starts with a screen clear,
+// so a dropped tail never garbles the view. Send 't' to toggle it at runtime.
+//
+// Send 'b' for binary telemetry instead: one frame per axis scan, decoded
+// (and optionally drawn as the same table) by tools/quadrant_telemetry.py.
+// Frame, little-endian:
+//   0xA5 0x5A  sync
+//   seq        uint8, advances every axis scan, so gaps show dropped frames
+//   axisCount  uint8
+//   buttonWords uint8
+//   buttons    uint32 per word, button 32w + n in bit n of word w
+//   per axis   raw | average << 12, mapped | stable << 12 (two 24-bit words)
+//   sum1 sum2  Fletcher-style byte sums (mod 256) over seq..last axis byte
+const unsigned long TELEMETRY_PERIOD_MS = 100;
+
+enum TelemetryMode : uint8_t
+{
+  TELEMETRY_OFF,
+  TELEMETRY_TABLE,
+  TELEMETRY_BINARY
+};
+
+TelemetryMode telemetryMode = TELEMETRY_TABLE;
+unsigned long telemetryFrameStartMs = 0;
+unsigned long telemetryFramesDropped = 0;
+uint8_t telemetryStep = 0;    // 0 = idle, otherwise the piece being written
+uint16_t telemetryOffset = 0; // bytes of that piece already written
+
+AxisSample telemetrySnapshot[NUM_AXES]; // copied at frame start
+
+const char TELEMETRY_CLEAR[] PROGMEM = "\033[2J\033[H";
+const char TELEMETRY_RULE[] PROGMEM =
+    "─────────────────────────────────────────────────────────────────────────────\r\n";
+const char TELEMETRY_HEADER[] PROGMEM =
+    "  Axis         Raw    Smoothed    Mapped     ΔMapped\r\n";
+
+enum TelemetryStep : uint8_t
+{
+  TELEMETRY_IDLE,
+  TELEMETRY_CLEAR_SCREEN,
+  TELEMETRY_TOP_RULE,
+  TELEMETRY_HEADER_ROW,
+  TELEMETRY_HEADER_RULE,
+  TELEMETRY_FIRST_AXIS_ROW,
+  TELEMETRY_BOTTOM_RULE = TELEMETRY_FIRST_AXIS_ROW + NUM_AXES
+};
+
+// Write as much of a piece as the CDC buffer takes right now; offset counts
+// the bytes already written. Returns true (and rewinds offset) once the whole
+// piece has gone out.
+bool streamWrite(const char *data, uint16_t len, bool inFlash, uint16_t &offset)
+{
+  while (offset < len)
+  {
+    int room = Serial.availableForWrite();
+    if (room <= 0)
+    {
+      return false;
+    }
+
+    uint8_t chunk[16];
+    uint16_t n = len - offset;
+    if (n > (uint16_t)room)
+      n = room;
+    if (n > sizeof(chunk))
+      n = sizeof(chunk);
+
+    if (inFlash)
+      memcpy_P(chunk, data + offset, n);
+    else
+      memcpy(chunk, data + offset, n);
+    Serial.write(chunk, n);
+    offset += n;
+  }
+  offset = 0;
+  return true;
+}
+
+bool telemetryWrite(const char *data, uint16_t len, bool inFlash)
+{
+  return streamWrite(data, len, inFlash, telemetryOffset);
+}
+
+// Copies a PROGMEM string, at most limit characters of it
+char *appendText_P(char *out, const char *text, uint8_t limit = 255)
+{
+  char c;
+  while (limit-- && (c = pgm_read_byte(text++)))
+    *out++ = c;
+  return out;
+}
+
+char *appendInt(char *out, int value)
+{
+  itoa(value, out, 10);
+  return out + strlen(out);
+}
+
+char *appendULong(char *out, unsigned long value)
+{
+  ultoa(value, out, 10);
+  return out + strlen(out);
+}
+
+// A row is the label (cut to TELEMETRY_LABEL_MAX, so a long profile label
+// cannot overrun the line buffer), 36 characters of separators and four ints
+const uint8_t TELEMETRY_LABEL_MAX = 20;
+const uint8_t TELEMETRY_ROW_MAX = TELEMETRY_LABEL_MAX + 36 + 4 * 6; // "-32768"
+
+uint8_t formatTelemetryRow(char *out, int axisIndex)
+{
+  const AxisSample &row = telemetrySnapshot[axisIndex];
+  char *p = out;
+  p = appendText_P(p, PSTR("  "));
+  p = appendText_P(p, axisDescriptor(axisIndex).label, TELEMETRY_LABEL_MAX);
+  p = appendText_P(p, PSTR("  |  "));
+  p = appendInt(p, row.raw);
+  p = appendText_P(p, PSTR("  |    "));
+  p = appendInt(p, row.average);
+  p = appendText_P(p, PSTR("     |   "));
+  p = appendInt(p, row.mapped);
+  p = appendText_P(p, PSTR("     |     "));
+  p = appendInt(p, abs(row.mapped - row.stable));
+  p = appendText_P(p, PSTR("\r\n"));
+  return p - out;
+}
+
+const uint8_t BINARY_SYNC_0 = 0xA5;
+const uint8_t BINARY_SYNC_1 = 0x5A;
+const uint8_t BINARY_FRAME_SIZE = 2 + 1 + 1 + 1 + 4 * BUTTON_WORDS + 6 * NUM_AXES + 2;
+static_assert(AXIS_SAMPLE_BITS <= 12, "binary telemetry packs axis values in 12 bits");
+
+uint8_t binarySeq = 0;
+unsigned long binaryFrameScanUs = 0; // axisScanUs of the last frame built
+uint8_t binaryFrame[BINARY_FRAME_SIZE];
+bool binaryFramePending = false;     // frame built but not fully written yet
+
+uint8_t *putPair12(uint8_t *out, int low, int high)
+{
+  uint32_t word = ((uint32_t)high << 12) | (uint16_t)low;
+  *out++ = word;
+  *out++ = word >> 8;
+  *out++ = word >> 16;
+  return out;
+}
+
+void buildBinaryFrame(uint8_t seq)
+{
+  uint8_t *frame = binaryFrame;
+  uint8_t *p = frame;
+  *p++ = BINARY_SYNC_0;
+  *p++ = BINARY_SYNC_1;
+  *p++ = seq;
+  *p++ = NUM_AXES;
+  *p++ = BUTTON_WORDS;
+  for (uint8_t w = 0; w < BUTTON_WORDS; w++)
+  {
+    uint32_t buttons = stagedFrame.buttons[w];
+    for (uint8_t i = 0; i < 4; i++)
+    {
+      *p++ = buttons >> (8 * i);
+    }
+  }
+  for (uint8_t i = 0; i < NUM_AXES; i++)
+  {
+    const AxisSample &sample = axisSamples[i];
+    p = putPair12(p, sample.raw, sample.average);
+    p = putPair12(p, sample.mapped, sample.stable);
+  }
+
+  uint8_t sum1 = 0, sum2 = 0;
+  for (uint8_t *q = frame + 2; q < p; q++)
+  {
+    sum1 += *q;
+    sum2 += sum1;
+  }
+  *p++ = sum1;
+  *p++ = sum2;
+}
+
+// Frames go out through telemetryWrite(), so one larger than the CDC buffer
+// is split across loops. A scan that completes while the previous frame is
+// still going out is dropped rather than interleaved, so the stream stays
+// frame-aligned and the scan never waits on the host.
+void sendBinaryTelemetry()
+{
+  if (axisScanUs != binaryFrameScanUs)
+  {
+    binaryFrameScanUs = axisScanUs;
+    uint8_t seq = binarySeq++;
+    if (binaryFramePending)
+    {
+      telemetryFramesDropped++;
+    }
+    else
+    {
+      buildBinaryFrame(seq);
+      binaryFramePending = true;
+    }
+  }
+
+  if (binaryFramePending && telemetryWrite((const char *)binaryFrame, BINARY_FRAME_SIZE, false))
+  {
+    binaryFramePending = false;
+  }
+}
+
+void setTelemetryMode(TelemetryMode mode)
+{
+  telemetryMode = mode;
+  telemetryStep = TELEMETRY_IDLE;
+  telemetryOffset = 0;
+  binaryFramePending = false;
+}
+
+// holdTable pauses the table between pieces (binary frames keep going)
+void printAxisDebug(bool holdTable)
+{
+  if (telemetryMode == TELEMETRY_BINARY && Serial.dtr())
+  {
+    sendBinaryTelemetry();
+    return;
+  }
+  if (telemetryMode != TELEMETRY_TABLE || !Serial.dtr())
+  {
+    telemetryStep = TELEMETRY_IDLE;
+    telemetryOffset = 0;
+    return;
+  }
+  if (holdTable && telemetryOffset == 0)
+  {
+    telemetryStep = TELEMETRY_IDLE; // keep the serial command output on screen
+    return;
+  }
+
+  unsigned long now = millis();
+  if (now - telemetryFrameStartMs >= TELEMETRY_PERIOD_MS)
+  {
+    if (telemetryStep != TELEMETRY_IDLE)
+    {
+      telemetryFramesDropped++;
+    }
+    telemetryFrameStartMs = now;
+    telemetryStep = TELEMETRY_CLEAR_SCREEN;
+    telemetryOffset = 0;
+    memcpy(telemetrySnapshot, axisSamples, sizeof(telemetrySnapshot));
+  }
+
+  while (telemetryStep != TELEMETRY_IDLE)
+  {
+    bool done;
+    if (telemetryStep == TELEMETRY_CLEAR_SCREEN)
+    {
+      done = telemetryWrite(TELEMETRY_CLEAR, sizeof(TELEMETRY_CLEAR) - 1, true);
+    }
+    else if (telemetryStep == TELEMETRY_HEADER_ROW)
+    {
+      done = telemetryWrite(TELEMETRY_HEADER, sizeof(TELEMETRY_HEADER) - 1, true);
+    }
+    else if (telemetryStep >= TELEMETRY_FIRST_AXIS_ROW && telemetryStep < TELEMETRY_BOTTOM_RULE)
+    {
+      char line[TELEMETRY_ROW_MAX + 1]; // itoa() writes a terminator
+      uint8_t len = formatTelemetryRow(line, telemetryStep - TELEMETRY_FIRST_AXIS_ROW);
+      done = telemetryWrite(line, len, false);
+    }
+    else
+    {
+      done = telemetryWrite(TELEMETRY_RULE, sizeof(TELEMETRY_RULE) - 1, true);
+    }
+
+    if (!done)
+    {
+      return; // CDC buffer full — resume on the next loop
+    }
+    telemetryStep = (telemetryStep == TELEMETRY_BOTTOM_RULE) ? TELEMETRY_IDLE : telemetryStep + 1;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Benchmark Loopback (env:leonardo_bench only)
+// -----------------------------------------------------------------------------
+// Jumper BENCH_LOOPBACK_PIN to a spare expander input (button 31, chip 1 GPB7,
+// by default) and tools/quadrant_bench.py can time press-to-report latency
+// and report rate end to end over USB:
+//   p / u  drive the loopback low (pressed) / release it
+//   w      toggle a square wave on it, each level held for twice the
+//          debounce time so every edge is taken
+#ifdef QUADRANT_BENCH
+const uint8_t BENCH_LOOPBACK_PIN = 5;
+
+unsigned long benchWigglePeriodUs()
+{
+  return 2UL * DEBOUNCE_SAMPLES * params.buttonScanPeriodUs;
+}
+
+bool benchWiggle = false;
+bool benchPressed = false;
+unsigned long benchWiggleUs = 0;
+
+void benchDrive(bool pressed)
+{
+  benchPressed = pressed;
+  digitalWrite(BENCH_LOOPBACK_PIN, pressed ? LOW : HIGH);
+}
+
+void startBench()
+{
+  pinMode(BENCH_LOOPBACK_PIN, OUTPUT);
+  benchDrive(false);
+}
+
+void serviceBench(unsigned long now)
+{
+  if (benchWiggle && now - benchWiggleUs >= benchWigglePeriodUs())
+  {
+    benchWiggleUs = now;
+    benchDrive(!benchPressed);
+  }
+}
+#endif
+
+// -----------------------------------------------------------------------------
+// Binary Command Channel — live parameters (tools/quadrant_params.py)
+// -----------------------------------------------------------------------------
+// Shares the CDC port with the single-character commands: a frame starts
+// with COMMAND_SYNC, which no text command uses, and is collected a byte at a
+// time as it arrives. Commands run from loop() between scans, so a value
+// never changes halfway through one.
+//   request   0xA5 cmd param v0 v1 v2 v3 sum1 sum2            (9 bytes)
+//   response  0xA5 0x5C cmd status param v0 v1 v2 v3 sum1 sum2 (11 bytes)
+// Values are little-endian int32; sums as in the telemetry frame, over
+// cmd..v3. A partial request is dropped after COMMAND_TIMEOUT_MS. A response
+// waits for any telemetry piece or stats line being written to finish.
+const uint8_t COMMAND_SYNC = 0xA5;
+const uint8_t RESPONSE_SYNC_1 = 0x5C;
+const uint8_t COMMAND_FRAME_SIZE = 9;
+const uint8_t RESPONSE_FRAME_SIZE = 11;
+const unsigned long COMMAND_TIMEOUT_MS = 100;
+
+enum CommandCode : uint8_t
+{
+  CMD_GET = 0x01,
+  CMD_SET = 0x02,
+  CMD_COMMIT = 0x03,   // save the live parameters to EEPROM
+  CMD_DEFAULTS = 0x04, // restore the build defaults (commit to keep them)
+  CMD_RECORD = 0x05,   // value 1 starts, 0 stops input recording
+  CMD_REPLAY = 0x06,   // value 1 starts, 0 stops replay
+  CMD_REPLAY_SAMPLE = 0x07, // param = source as in the record frame; no response unless it fails
+  CMD_APPLY_CURVE = 0x08    // copy the staged user curve into the live one
+};
+
+enum CommandStatus : uint8_t
+{
+  STATUS_OK,
+  STATUS_UNKNOWN_PARAM,
+  STATUS_OUT_OF_RANGE,
+  STATUS_BAD_CHECKSUM,
+  STATUS_UNKNOWN_COMMAND,
+  STATUS_BUSY,    // an EEPROM commit is still being written
+  STATUS_INACTIVE // a replay sample arrived while no replay is running
+};
+
+enum ParamId : uint8_t
+{
+  PARAM_AXIS_SCAN_US = 0x01,
+  PARAM_BUTTON_SCAN_US = 0x02,
+  PARAM_KEEPALIVE_MS = 0x03,
+  PARAM_AXIS_REPORT_INTERVAL_US = 0x04,
+  PARAM_ONE_EURO_MIN_ALPHA = 0x05,
+  PARAM_ONE_EURO_BETA = 0x06,
+  PARAM_TRIM_GAIN_SCALE = 0x07,
+  PARAM_TRIM_NOISE_COUNTS = 0x08,
+  PARAM_SYNC_TOLERANCE = 0x09,
+  PARAM_SYNC_RELEASE = 0x0A,
+  PARAM_IDLE_TIMEOUT_MS = 0x0B,
+  PARAM_IDLE_SCAN_US = 0x0C,
+  PARAM_IDLE_KEEPALIVE_MS = 0x0D,
+  PARAM_IDLE_WAKE_COUNTS = 0x0E,
+  PARAM_DEADBAND = 0x10,   // + axis index
+  PARAM_CURVE = 0x20,      // + axis index, an AxisCurve
+  PARAM_USER_CURVE = 0x40, // + breakpoint index
+  PARAM_STAGED_CURVE = 0x80 // + breakpoint index, applied by CMD_APPLY_CURVE
+};
+
+struct ParamInfo
+{
+  uint8_t id;
+  uint8_t count; // consecutive ids, for per-axis arrays
+  uint8_t size;  // bytes per element
+  void *field;
+  int32_t minValue;
+  int32_t maxValue;
+};
+
+// User curve being uploaded. Setting the live breakpoints one at a time would
+// run every CURVE_USER axis through a half-old, half-new curve meanwhile, so
+// uploads go here and CMD_APPLY_CURVE swaps the whole curve in between scans.
+uint16_t stagedUserCurve[CURVE_POINTS];
+
+const ParamInfo PARAM_TABLE[] PROGMEM = {
+    {PARAM_AXIS_SCAN_US, 1, 2, &params.axisScanPeriodUs, 250, 20000},
+    {PARAM_BUTTON_SCAN_US, 1, 2, &params.buttonScanPeriodUs, 250, 20000},
+    {PARAM_KEEPALIVE_MS, 1, 2, &params.keepaliveMs, 0, 60000},
+    {PARAM_AXIS_REPORT_INTERVAL_US, 1, 2, &params.axisReportIntervalUs, 0, 50000},
+    {PARAM_ONE_EURO_MIN_ALPHA, 1, 2, &params.filter.oneEuroMinAlpha, 1, 256},
+    {PARAM_ONE_EURO_BETA, 1, 2, &params.filter.oneEuroBeta, 0, 256},
+    {PARAM_TRIM_GAIN_SCALE, 1, 2, &params.trim.gainScale, 16, 1024},
+    {PARAM_TRIM_NOISE_COUNTS, 1, 2, &params.trim.noiseCounts, 1, 256},
+    {PARAM_SYNC_TOLERANCE, 1, 2, &params.syncTolerance, 0, AXIS_OUTPUT_MAX},
+    {PARAM_SYNC_RELEASE, 1, 2, &params.syncRelease, 0, AXIS_OUTPUT_MAX},
+    {PARAM_IDLE_TIMEOUT_MS, 1, 2, &params.idleTimeoutMs, 0, 60000},
+    {PARAM_IDLE_SCAN_US, 1, 2, &params.idleScanPeriodUs, 1000, 50000},
+    {PARAM_IDLE_KEEPALIVE_MS, 1, 2, &params.idleKeepaliveMs, 0, 60000},
+    {PARAM_IDLE_WAKE_COUNTS, 1, 2, &params.idleWakeCounts, 1, 1 << AXIS_SAMPLE_BITS},
+    {PARAM_DEADBAND, NUM_AXES, 1, params.deadband, 0, 255},
+    {PARAM_CURVE, NUM_AXES, 1, params.curve, CURVE_LINEAR, CURVE_USER},
+    {PARAM_USER_CURVE, CURVE_POINTS, 2, params.userCurve, 0, (1 << CURVE_UNIT_BITS) - 1},
+    {PARAM_STAGED_CURVE, CURVE_POINTS, 2, stagedUserCurve, 0, (1 << CURVE_UNIT_BITS) - 1},
+};
+static_assert(NUM_AXES <= PARAM_CURVE - PARAM_DEADBAND, "per-axis parameter ids overlap");
+static_assert(CURVE_POINTS <= PARAM_STAGED_CURVE - PARAM_USER_CURVE, "curve parameter ids overlap");
+const uint8_t PARAM_COUNT = sizeof(PARAM_TABLE) / sizeof(PARAM_TABLE[0]);
+
+// Committed copy of params, after the trim records
+const int PARAMS_EEPROM_ADDRESS = TRIM_EEPROM_ADDRESS + TRIM_EEPROM_SIZE;
+const uint16_t PARAMS_MAGIC = 0x5051; // "QP"
+const uint8_t PARAMS_VERSION = 2; // bump whenever RuntimeParams changes, even at the same size
+
+// A block from another layout or sample width (the count-valued fields are
+// in sample units), or with any value outside its PARAM_TABLE range, is
+// ignored and the build defaults stay in place.
+struct ParamsBlock
+{
+  uint16_t magic;
+  uint8_t version;
+  uint8_t sampleBits; // AXIS_SAMPLE_BITS the block was recorded with
+  uint8_t size; // sizeof(RuntimeParams) when written
+  RuntimeParams values;
+  uint16_t crc; // CRC-16 over every byte before it
+};
+static_assert(PARAMS_EEPROM_ADDRESS + sizeof(ParamsBlock) <= E2END + 1, "calibration, trim and params overflow the EEPROM");
+
+uint8_t commandFrame[COMMAND_FRAME_SIZE];
+uint8_t commandLength = 0; // 0 = not inside a frame
+unsigned long commandStartMs = 0;
+uint8_t responseFrame[RESPONSE_FRAME_SIZE];
+bool responsePending = false; // responseFrame waits for serviceCommandResponse()
+ParamsBlock paramsSave;
+uint8_t paramsSaveNext = sizeof(ParamsBlock); // == size: no save in progress
+
+void defaultParams()
+{
+  params.axisScanPeriodUs = AXIS_SCAN_PERIOD_US;
+  params.buttonScanPeriodUs = BUTTON_SCAN_PERIOD_US;
+  params.keepaliveMs = HID_KEEPALIVE_MS;
+  params.axisReportIntervalUs = AXIS_MIN_REPORT_INTERVAL_US;
+  params.filter.oneEuroMinAlpha = ONE_EURO_MIN_ALPHA;
+  params.filter.oneEuroBeta = ONE_EURO_BETA;
+  params.trim.gainScale = 256;
+  params.trim.noiseCounts = TRIM_NOISE_COUNTS;
+  params.syncTolerance = THROTTLE_SYNC_TOLERANCE;
+  params.syncRelease = THROTTLE_SYNC_RELEASE;
+  params.idleTimeoutMs = IDLE_TIMEOUT_MS;
+  params.idleScanPeriodUs = IDLE_SCAN_PERIOD_US;
+  params.idleKeepaliveMs = IDLE_KEEPALIVE_MS;
+  params.idleWakeCounts = IDLE_WAKE_COUNTS;
+  for (uint8_t i = 0; i < NUM_AXES; i++)
+  {
+    AxisDescriptor axis = axisDescriptor(i);
+    params.deadband[i] = axis.deadband;
+    params.curve[i] = axis.curve;
+  }
+  for (uint8_t i = 0; i < CURVE_POINTS; i++)
+  {
+    params.userCurve[i] = ((uint32_t)i << CURVE_UNIT_BITS) / CURVE_SEGMENTS - (i == CURVE_SEGMENTS); // linear
+  }
+}
+
+// Push parameters that are cached elsewhere
+void applyParams()
+{
+  setScanPeriods();
+  adcWakeArmed = false; // the ISR must not see a half-written threshold
+  adcWakeCounts = params.idleWakeCounts;
+  adcWakeArmed = scanIdle;
+}
+
+void serviceParamsSave()
+{
+  if (paramsSaveNext < sizeof(ParamsBlock))
+  {
+    trickleWriteEeprom(PARAMS_EEPROM_ADDRESS, (const uint8_t *)&paramsSave, sizeof(ParamsBlock), paramsSaveNext);
+  }
+}
+
+bool findParam(uint8_t id, ParamInfo &info, uint8_t &element)
+{
+  for (uint8_t i = 0; i < PARAM_COUNT; i++)
+  {
+    memcpy_P(&info, &PARAM_TABLE[i], sizeof(ParamInfo));
+    if (id >= info.id && id < info.id + info.count)
+    {
+      element = id - info.id;
+      return true;
+    }
+  }
+  return false;
+}
+
+int32_t readParam(const ParamInfo &info, uint8_t element)
+{
+  if (info.size == 1)
+    return ((uint8_t *)info.field)[element];
+  return ((uint16_t *)info.field)[element];
+}
+
+void writeParam(const ParamInfo &info, uint8_t element, int32_t value)
+{
+  if (info.size == 1)
+    ((uint8_t *)info.field)[element] = value;
+  else
+    ((uint16_t *)info.field)[element] = value;
+}
+
+// Every value in params that PARAM_TABLE covers is within its range
+bool paramsInRange()
+{
+  ParamInfo info;
+  for (uint8_t i = 0; i < PARAM_COUNT; i++)
+  {
+    memcpy_P(&info, &PARAM_TABLE[i], sizeof(ParamInfo));
+    const uint8_t *field = (const uint8_t *)info.field;
+    if (field < (const uint8_t *)&params || field >= (const uint8_t *)&params + sizeof(params))
+    {
+      continue; // not part of the committed block (the staged curve)
+    }
+    for (uint8_t element = 0; element < info.count; element++)
+    {
+      int32_t value = readParam(info, element);
+      if (value < info.minValue || value > info.maxValue)
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool loadParams()
+{
+  ParamsBlock block;
+  EEPROM.get(PARAMS_EEPROM_ADDRESS, block);
+  if (block.magic != PARAMS_MAGIC || block.version != PARAMS_VERSION ||
+      block.sampleBits != AXIS_SAMPLE_BITS || block.size != sizeof(RuntimeParams) ||
+      block.crc != eepromCrc(&block, offsetof(ParamsBlock, crc)))
+  {
+    return false;
+  }
+  params = block.values;
+  if (!paramsInRange())
+  {
+    defaultParams();
+    return false;
+  }
+  return true;
+}
+
+void checksumBytes(const uint8_t *data, uint8_t length, uint8_t &sum1, uint8_t &sum2)
+{
+  sum1 = 0;
+  sum2 = 0;
+  for (uint8_t i = 0; i < length; i++)
+  {
+    sum1 += data[i];
+    sum2 += sum1;
+  }
+}
+
+// Held until serviceCommandResponse() can write it whole; dropped if one is
+// already waiting, and the host retries
+void sendCommandResponse(uint8_t cmd, uint8_t status, uint8_t param, int32_t value)
+{
+  if (responsePending)
+  {
+    return;
+  }
+  uint8_t *frame = responseFrame;
+  frame[0] = COMMAND_SYNC;
+  frame[1] = RESPONSE_SYNC_1;
+  frame[2] = cmd;
+  frame[3] = status;
+  frame[4] = param;
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    frame[5 + i] = (uint32_t)value >> (8 * i);
+  }
+  checksumBytes(frame + 2, 7, frame[9], frame[10]);
+  responsePending = true;
+}
+
+void executeCommand()
+{
+  uint8_t cmd = commandFrame[1];
+  uint8_t id = commandFrame[2];
+  int32_t value = 0;
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    value |= (int32_t)commandFrame[3 + i] << (8 * i);
+  }
+
+  uint8_t sum1, sum2;
+  checksumBytes(commandFrame + 1, 6, sum1, sum2);
+  if (sum1 != commandFrame[7] || sum2 != commandFrame[8])
+  {
+    sendCommandResponse(cmd, STATUS_BAD_CHECKSUM, id, 0);
+    return;
+  }
+
+  ParamInfo info;
+  uint8_t element;
+  switch (cmd)
+  {
+  case CMD_GET:
+  case CMD_SET:
+    if (!findParam(id, info, element))
+    {
+      sendCommandResponse(cmd, STATUS_UNKNOWN_PARAM, id, 0);
+      return;
+    }
+    if (cmd == CMD_SET)
+    {
+      if (value < info.minValue || value > info.maxValue)
+      {
+        sendCommandResponse(cmd, STATUS_OUT_OF_RANGE, id, readParam(info, element));
+        return;
+      }
+      writeParam(info, element, value);
+      applyParams();
+    }
+    sendCommandResponse(cmd, STATUS_OK, id, readParam(info, element));
+    break;
+  case CMD_COMMIT:
+    if (paramsSaveNext < sizeof(ParamsBlock))
+    {
+      sendCommandResponse(cmd, STATUS_BUSY, id, 0);
+      return;
+    }
+    paramsSave.magic = PARAMS_MAGIC;
+    paramsSave.version = PARAMS_VERSION;
+    paramsSave.sampleBits = AXIS_SAMPLE_BITS;
+    paramsSave.size = sizeof(RuntimeParams);
+    paramsSave.values = params;
+    paramsSave.crc = eepromCrc(&paramsSave, offsetof(ParamsBlock, crc));
+    paramsSaveNext = 0; // written by serviceParamsSave()
+    sendCommandResponse(cmd, STATUS_OK, id, sizeof(ParamsBlock));
+    break;
+  case CMD_APPLY_CURVE:
+    memcpy(params.userCurve, stagedUserCurve, sizeof(params.userCurve));
+    applyParams();
+    sendCommandResponse(cmd, STATUS_OK, id, 0);
+    break;
+  case CMD_DEFAULTS:
+    defaultParams();
+    applyParams();
+    sendCommandResponse(cmd, STATUS_OK, id, 0);
+    break;
+  case CMD_RECORD:
+    if (value && !recording)
+    {
+      setTelemetryMode(TELEMETRY_OFF); // the port carries only record frames
+      recordHead = recordTail = 0;
+      recordAllButtons = true;
+      requestButtonRead(); // the full snapshot is timed from this frame
+    }
+    recording = value != 0;
+    sendCommandResponse(cmd, STATUS_OK, id, recordEventsDropped);
+    break;
+  case CMD_REPLAY:
+    if (value && !replaying)
+    {
+      stopAdcSampling();
+      for (uint8_t w = 0; w < BUTTON_WORDS; w++)
+      {
+        replayButtons[w] = debouncers[w].state;
+      }
+    }
+    else if (!value && replaying)
+    {
+      startAdcSampling();
+    }
+    replaying = value != 0;
+    if (replaying)
+    {
+      requestReplayRead();
+    }
+    else
+    {
+      requestButtonRead(); // back to the real expanders, timed from now
+    }
+    sendCommandResponse(cmd, STATUS_OK, id, 0);
+    break;
+  case CMD_REPLAY_SAMPLE:
+    if (!replaying)
+    {
+      sendCommandResponse(cmd, STATUS_INACTIVE, id, value);
+    }
+    else if (id < NUM_AXES)
+    {
+      if (value < 0 || value > (1 << AXIS_SAMPLE_BITS) - 1)
+      {
+        sendCommandResponse(cmd, STATUS_OUT_OF_RANGE, id, value);
+        return;
+      }
+      replayAxisSample(id, value);
+    }
+    else if (id >= RECORD_BUTTONS && id < RECORD_BUTTONS + BUTTON_WORDS)
+    {
+      replayButtons[id - RECORD_BUTTONS] = value;
+      requestReplayRead();
+    }
+    else
+    {
+      sendCommandResponse(cmd, STATUS_UNKNOWN_PARAM, id, value);
+    }
+    break;
+  default:
+    sendCommandResponse(cmd, STATUS_UNKNOWN_COMMAND, id, 0);
+    break;
+  }
+}
+
+// Collects one byte of a frame; the complete frame is executed and text
+// commands resume with the next byte
+void receiveCommandByte(uint8_t c)
+{
+  commandFrame[commandLength++] = c;
+  if (commandLength == COMMAND_FRAME_SIZE)
+  {
+    executeCommand();
+    commandLength = 0;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Serial Commands — single-character, read without blocking
+// -----------------------------------------------------------------------------
+//   t  toggle the live debug table, not while recording
+//   b  toggle binary telemetry frames (tools/quadrant_telemetry.py), not while recording
+//   i  print I2C bus counters
+//   s  print loop timing, report counts and the latency histogram
+//   r  reset those counters
+//   c  start / save an axis calibration sweep, x cancel it, d defaults
+//   p, u, w  benchmark loopback (QUADRANT_BENCH builds, see above)
+//   0xA5 starts a binary command frame (see Binary Command Channel)
+// 'i' and 's' answer with a report of a few lines, and so do the calibration
+// commands. Each line is formatted when the one before it has gone out and is
+// written through streamWrite(), so a report never holds up a scan. Lines only
+// start between telemetry pieces and the telemetry waits while a line is half
+// written, so the two never interleave. A request while a report is still
+// going out waits behind it; one more beyond that is ignored. The table is
+// paused during a calibration sweep and its report, so its screen clears
+// never wipe the prompt or the results.
+enum StatsLine : uint8_t
+{
+  STATS_IDLE,
+  STATS_I2C_BUS, // 'i'
+  STATS_I2C_SCAN,
+  STATS_LOOP, // 's'
+  STATS_BUTTONS,
+  STATS_AXES,
+  STATS_HID,
+  STATS_DEBUG,
+  STATS_REPORTS,
+  STATS_OVERRUNS,
+  STATS_DROPPED,
+  STATS_MODES,
+  STATS_LATENCY_LOW,
+  STATS_LATENCY_HIGH,
+  STATS_FIRST_REPORT,
+  STATS_CALIBRATION_PROMPT, // 'c'
+  STATS_CALIBRATION_CANCELLED, // 'x'
+  STATS_CALIBRATION_DEFAULTS,  // 'd'
+  STATS_CALIBRATION_FIRST_AXIS, // 'c' again: one line per axis
+  STATS_CALIBRATION_SAVED = STATS_CALIBRATION_FIRST_AXIS + NUM_AXES
+};
+
+// Longest line: five 10-digit counters and at most 48 characters of text
+const uint8_t STATS_LINE_MAX = 5 * 10 + 48;
+
+uint8_t statsLine = STATS_IDLE; // line being written
+uint8_t statsLast = STATS_IDLE; // last line of the report
+char statsText[STATS_LINE_MAX + 1];
+uint8_t statsLength = 0; // 0 = next line not formatted yet
+uint16_t statsOffset = 0;
+uint8_t statsPendingFirst = STATS_IDLE; // report queued behind the current one
+uint8_t statsPendingLast = STATS_IDLE;
+
+void requestStats(uint8_t first, uint8_t last)
+{
+  if (statsLine == STATS_IDLE)
+  {
+    statsLine = first;
+    statsLast = last;
+  }
+  else if (statsPendingFirst == STATS_IDLE)
+  {
+    statsPendingFirst = first;
+    statsPendingLast = last;
+  }
+}
+
+bool isCalibrationResult(uint8_t line)
+{
+  return line >= STATS_CALIBRATION_FIRST_AXIS && line <= STATS_CALIBRATION_SAVED;
+}
+
+// True while the results of a sweep are still queued or going out
+bool calibrationReporting()
+{
+  return isCalibrationResult(statsLine) || isCalibrationResult(statsPendingFirst);
+}
+
+char *appendTiming(char *p, const char *name, const StageTiming &timing)
+{
+  p = appendText_P(p, name);
+  p = appendText_P(p, PSTR(" last="));
+  p = appendULong(p, timing.lastUs);
+  p = appendText_P(p, PSTR(" min="));
+  p = appendULong(p, timing.count ? timing.minUs : 0);
+  p = appendText_P(p, PSTR(" avg="));
+  p = appendULong(p, timing.count ? timing.totalUs / timing.count : 0);
+  p = appendText_P(p, PSTR(" max="));
+  p = appendULong(p, timing.maxUs);
+  p = appendText_P(p, PSTR(" us  n="));
+  return appendULong(p, timing.count);
+}
+
+// Buckets first..first+3 of the latency histogram
+char *appendLatency(char *p, uint8_t first)
+{
+  p = appendText_P(p, PSTR("latency"));
+  for (uint8_t b = first; b < first + LATENCY_BUCKETS / 2; b++)
+  {
+    bool last = (b == LATENCY_BUCKETS - 1);
+    p = appendText_P(p, last ? PSTR(" >=") : PSTR(" <"));
+    p = appendULong(p, 125UL << (last ? b - 1 : b));
+    p = appendText_P(p, PSTR("us:"));
+    p = appendULong(p, latencyHistogram[b]);
+  }
+  return p;
+}
+
+uint8_t formatStatsLine(char *out, uint8_t line)
+{
+  char *p = out;
+  switch (line)
+  {
+  case STATS_I2C_BUS:
+    p = appendText_P(p, PSTR("I2C "));
+    p = appendULong(p, I2C_CLOCK_HZ / 1000);
+    p = appendText_P(p, PSTR(" kHz  nack="));
+    p = appendULong(p, i2cStats.nacks);
+    p = appendText_P(p, PSTR(" timeout="));
+    p = appendULong(p, i2cStats.timeouts);
+    p = appendText_P(p, PSTR(" error="));
+    p = appendULong(p, i2cStats.errors);
+    p = appendText_P(p, PSTR(" recovered="));
+    p = appendULong(p, i2cStats.recoveries);
+    break;
+  case STATS_I2C_SCAN:
+    p = appendText_P(p, PSTR("I2C scan="));
+    p = appendULong(p, i2cStats.lastScanUs);
+    p = appendText_P(p, PSTR("us max="));
+    p = appendULong(p, i2cStats.maxScanUs);
+    p = appendText_P(p, PSTR("us  backing off chips="));
+    for (uint8_t chip = 0; chip < EXPANDER_COUNT; chip++)
+    {
+      *p++ = expanderFailures[chip] > 1 ? '0' + chip : '-';
+    }
+    break;
+  case STATS_LOOP:
+    p = appendTiming(p, PSTR("loop   "), loopPeriod);
+    break;
+  case STATS_BUTTONS:
+    p = appendTiming(p, PSTR("buttons"), buttonTiming);
+    break;
+  case STATS_AXES:
+    p = appendTiming(p, PSTR("axes   "), axisTiming);
+    break;
+  case STATS_HID:
+    p = appendTiming(p, PSTR("hid    "), hidTiming);
+    break;
+  case STATS_DEBUG:
+    p = appendTiming(p, PSTR("debug  "), telemetryTiming);
+    break;
+  case STATS_REPORTS:
+    p = appendText_P(p, PSTR("reports sent="));
+    p = appendULong(p, hidReportsSent);
+    p = appendText_P(p, PSTR(" suppressed="));
+    p = appendULong(p, hidReportsSuppressed);
+    p = appendText_P(p, PSTR(" keepalive="));
+    p = appendULong(p, hidKeepalivesSent);
+    p = appendText_P(p, PSTR(" deferred="));
+    p = appendULong(p, hidAxisUpdatesDeferred);
+    break;
+  case STATS_OVERRUNS:
+    p = appendText_P(p, PSTR("overruns axes="));
+    p = appendULong(p, axisTask.overruns);
+    p = appendText_P(p, PSTR(" buttons="));
+    p = appendULong(p, buttonTask.overruns);
+    p = appendText_P(p, PSTR(" adc="));
+    p = appendULong(p, adcOverruns);
+    break;
+  case STATS_DROPPED:
+    p = appendText_P(p, PSTR("dropped debug="));
+    p = appendULong(p, telemetryFramesDropped);
+    p = appendText_P(p, PSTR(" record="));
+    p = appendULong(p, recordEventsDropped);
+    break;
+  case STATS_MODES:
+    p = appendText_P(p, PSTR("sync locks="));
+    p = appendULong(p, throttleSyncLocks);
+    p = appendText_P(p, throttlesLocked ? PSTR(" (locked)") : PSTR(""));
+    p = appendText_P(p, PSTR("  idle entries="));
+    p = appendULong(p, idleEntries);
+    p = appendText_P(p, scanIdle ? PSTR(" (idle)") : PSTR(""));
+    break;
+  case STATS_LATENCY_LOW:
+    p = appendLatency(p, 0);
+    break;
+  case STATS_LATENCY_HIGH:
+    p = appendLatency(p, LATENCY_BUCKETS / 2);
+    break;
+  case STATS_FIRST_REPORT:
+    p = appendText_P(p, PSTR("first report "));
+    p = appendULong(p, bootToFirstReportUs);
+    p = appendText_P(p, PSTR(" us after boot"));
+    break;
+  case STATS_CALIBRATION_PROMPT:
+    p = appendText_P(p, PSTR("Calibrating: move every axis end to end, then send 'c' to save or 'x' to cancel"));
+    break;
+  case STATS_CALIBRATION_CANCELLED:
+    p = appendText_P(p, PSTR("Calibration cancelled"));
+    break;
+  case STATS_CALIBRATION_DEFAULTS:
+    p = appendText_P(p, PSTR("Calibration reset to defaults"));
+    break;
+  case STATS_CALIBRATION_SAVED:
+    p = appendText_P(p, PSTR("Calibration saved"));
+    break;
+  default:
+    if (isCalibrationResult(line))
+    {
+      uint8_t i = line - STATS_CALIBRATION_FIRST_AXIS;
+      p = appendText_P(p, axisDescriptor(i).label, TELEMETRY_LABEL_MAX);
+      p = appendText_P(p, PSTR("  min="));
+      p = appendULong(p, calibrationMin[i]);
+      p = appendText_P(p, PSTR(" max="));
+      p = appendULong(p, calibrationMax[i]);
+      p = appendText_P(p, calibrationSwept(i) ? PSTR("") : PSTR("  (kept)"));
+    }
+    break;
+  }
+  p = appendText_P(p, PSTR("\r\n"));
+  return p - out;
+}
+
+void serviceStats()
+{
+  while (statsLine != STATS_IDLE)
+  {
+    if (statsLength == 0)
+    {
+      if (telemetryOffset != 0)
+      {
+        return; // a telemetry piece is half written
+      }
+      statsLength = formatStatsLine(statsText, statsLine);
+    }
+    if (!streamWrite(statsText, statsLength, false, statsOffset))
+    {
+      return;
+    }
+    statsLength = 0;
+    if (statsLine != statsLast)
+    {
+      statsLine++;
+    }
+    else
+    {
+      statsLine = statsPendingFirst;
+      statsLast = statsPendingLast;
+      statsPendingFirst = STATS_IDLE;
+    }
+  }
+}
+
+// Whole-frame writers (command responses, record frames) only go out between
+// telemetry pieces and stats lines, never into the middle of one
+bool streamBetweenPieces()
+{
+  return telemetryOffset == 0 && statsLength == 0;
+}
+
+void serviceCommandResponse()
+{
+  if (responsePending && streamBetweenPieces() && Serial.availableForWrite() >= RESPONSE_FRAME_SIZE)
+  {
+    Serial.write(responseFrame, RESPONSE_FRAME_SIZE);
+    responsePending = false;
+  }
+}
+
+// Writes queued record events as whole frames while the CDC buffer has room
+void serviceRecording()
+{
+  while (recordTail != recordHead && streamBetweenPieces() && Serial.availableForWrite() >= RECORD_FRAME_SIZE)
+  {
+    const RecordEvent &event = recordQueue[recordTail & (RECORD_QUEUE_SIZE - 1)];
+    uint8_t frame[RECORD_FRAME_SIZE];
+    frame[0] = BINARY_SYNC_0;
+    frame[1] = RECORD_SYNC_1;
+    frame[2] = event.seq;
+    frame[3] = event.source;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+      frame[4 + i] = event.us >> (8 * i);
+      frame[8 + i] = event.value >> (8 * i);
+    }
+    uint8_t sum1 = 0, sum2 = 0;
+    for (uint8_t i = 2; i < RECORD_FRAME_SIZE - 2; i++)
+    {
+      sum1 += frame[i];
+      sum2 += sum1;
+    }
+    frame[12] = sum1;
+    frame[13] = sum2;
+    Serial.write(frame, RECORD_FRAME_SIZE);
+    recordTail++;
+  }
+}
+
+// The banner goes out once a host raises DTR, and only when it fits the CDC
+// buffer; a port nobody opens costs nothing.
+bool serialAttached = false;
+
+void serviceSerialAttach()
+{
+  bool dtr = Serial.dtr();
+  if (dtr && !serialAttached)
+  {
+    if (Serial.availableForWrite() < 56)
+    {
+      return; // try again next loop
+    }
+    Serial.print(F("Throttle Debug Initialized, first report "));
+    Serial.print(bootToFirstReportUs);
+    Serial.println(F(" us"));
+  }
+  serialAttached = dtr;
+}
+
+void handleSerialCommands()
+{
+  if (commandLength > 0 && millis() - commandStartMs >= COMMAND_TIMEOUT_MS)
+  {
+    commandLength = 0; // host went away mid-frame
+  }
+
+  while (Serial.available() > 0)
+  {
+    uint8_t c = Serial.read();
+    if (commandLength > 0)
+    {
+      receiveCommandByte(c);
+      continue;
+    }
+
+    switch (c)
+    {
+    case COMMAND_SYNC:
+      commandStartMs = millis();
+      receiveCommandByte(c);
+      break;
+    case 't':
+      if (!recording) // the port carries only record frames
+      {
+        setTelemetryMode(telemetryMode == TELEMETRY_TABLE ? TELEMETRY_OFF : TELEMETRY_TABLE);
+      }
+      break;
+    case 'b':
+      if (!recording)
+      {
+        setTelemetryMode(telemetryMode == TELEMETRY_BINARY ? TELEMETRY_OFF : TELEMETRY_BINARY);
+      }
+      break;
+    case 'i':
+      requestStats(STATS_I2C_BUS, STATS_I2C_SCAN);
+      break;
+    case 's':
+      requestStats(STATS_LOOP, STATS_FIRST_REPORT);
+      break;
+    case 'r':
+      resetInstrumentation();
+      break;
+    case 'c':
+      if (calibrating)
+      {
+        finishCalibration();
+        requestStats(STATS_CALIBRATION_FIRST_AXIS, STATS_CALIBRATION_SAVED);
+      }
+      else if (!calibrationReporting()) // the report reads calibrationMin/Max
+      {
+        startCalibration();
+        requestStats(STATS_CALIBRATION_PROMPT, STATS_CALIBRATION_PROMPT);
+      }
+      break;
+    case 'x':
+      if (calibrating)
+      {
+        calibrating = false;
+        requestStats(STATS_CALIBRATION_CANCELLED, STATS_CALIBRATION_CANCELLED);
+      }
+      break;
+    case 'd':
+      calibrating = false;
+      clearCalibration();
+      requestStats(STATS_CALIBRATION_DEFAULTS, STATS_CALIBRATION_DEFAULTS);
+      break;
+#ifdef QUADRANT_BENCH
+    case 'p':
+      benchWiggle = false;
+      benchDrive(true);
+      break;
+    case 'u':
+      benchWiggle = false;
+      benchDrive(false);
+      break;
+    case 'w':
+      benchWiggle = !benchWiggle;
+      benchDrive(false);
+      break;
+#endif
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Setup Routine
+// -----------------------------------------------------------------------------
+// HID comes first: the first report goes out as soon as the host has
+// configured the device and the inputs have been read once, whether or not a
+// host ever opens the serial port. A port with no host on it (a charger)
+// gives up the wait after USB_ENUMERATION_TIMEOUT_MS and reports from loop()
+// once it is configured.
+const unsigned long USB_ENUMERATION_TIMEOUT_MS = 2000;
+
+void setup()
+{
+  UnrollAxes<SetAxisRange>::run();
+  Joystick.begin(false); // Manual send: one report per scan via commitHidFrame()
+  if (SPLIT_REPORTS)
+  {
+    ButtonReport.begin(false);
+  }
+
+  UnrollAxes<DefaultCalibration>::run();
+  loadCalibration(); // before priming, which scales the first samples
+  defaultParams();
+  loadParams();
+  memcpy(stagedUserCurve, params.userCurve, sizeof(stagedUserCurve));
+  applyParams();
+
+  Wire.begin();
+  configureI2cBus(); // bounds the expander probes below if the bus is stuck
+  for (uint8_t chip = 0; chip < EXPANDER_COUNT; chip++)
+  {
+    expanders[chip].begin_I2C(EXPANDER_BASE_ADDRESS + chip);
+  }
+  configureI2cBus();
+
+  for (uint8_t chip = 0; chip < EXPANDER_COUNT; chip++)
+  {
+    Adafruit_MCP23X17 &mcp = expanders[chip];
+    for (int i = 0; i < 16; i++)
+    {
+      mcp.pinMode(i, INPUT_PULLUP);
+    }
+    if (EXPANDER_INT_PIN >= 0)
+    {
+      // Mirrored INTA/INTB, open drain so every chip can share one line
+      mcp.setupInterrupts(true, true, LOW);
+      for (int i = 0; i < 16; i++)
+      {
+        mcp.setupInterruptPin(i, CHANGE);
+      }
+    }
+  }
+
+  if (EXPANDER_INT_PIN >= 0)
+  {
+    pinMode(EXPANDER_INT_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(EXPANDER_INT_PIN), onExpanderInterrupt, FALLING);
+  }
+
+  // Enumeration runs from the USB interrupt; the axes are primed after it so
+  // the first report carries fresh samples
+  unsigned long enumerationStartMs = millis();
+  while (!USBDevice.configured() && millis() - enumerationStartMs < USB_ENUMERATION_TIMEOUT_MS)
+  {
+  }
+  UnrollAxes<PrimeAxis>::run();
+  startAdcSampling();
+
+  readButtons();
+  readAxes();
+  commitHidFrame();
+
+  Serial.begin(9600); // never waited on; see serviceSerialAttach()
+
+#ifdef QUADRANT_BENCH
+  startBench();
+  telemetryMode = TELEMETRY_OFF; // keep the measured loop free of debug output
+#endif
+
+  resetInstrumentation();
+  unsigned long now = micros();
+  startTask(buttonTask, now);
+  startTask(axisTask, now);
+  lastLoopUs = now;
+}
+
+// -----------------------------------------------------------------------------
+// Main Loop — Scheduled Scans, One HID Commit per Scan, Debug in Idle Time
+// -----------------------------------------------------------------------------
+void loop()
+{
+  unsigned long now = micros();
+  recordTiming(loopPeriod, now - lastLoopUs);
+  lastLoopUs = now;
+
+  serviceIdle(now);
+
+  bool scanned = false;
+  unsigned long t = now;
+
+  // A change flagged by the expander INT line is read on the next button
+  // tick, like any other debounce sample
+  if (taskDue(buttonTask, now))
+  {
+    readButtons();
+    t = recordStage(buttonTiming, t);
+    scanned = true;
+  }
+  if (taskDue(axisTask, now))
+  {
+    readAxes();
+    t = recordStage(axisTiming, t);
+    scanned = true;
+  }
+  if (scanned)
+  {
+    commitHidFrame();
+    t = recordStage(hidTiming, t);
+  }
+
+  serviceSerialAttach();
+  handleSerialCommands();
+  serviceParamsSave();
+  serviceCalibrationSave();
+#ifdef QUADRANT_BENCH
+  serviceBench(now);
+#endif
+  t = micros();
+  serviceCommandResponse();
+  serviceStats();
+  if (statsLength == 0) // not while a stats line is half written
+  {
+    printAxisDebug(calibrating || calibrationReporting());
+  }
+  serviceRecording();
+  recordStage(telemetryTiming, t);
 }
@@ -0,0 +1,395 @@
+// -----------------------------------------------------------------------------
+// Input Pipeline Unit Tests — pio test -e native
+// -----------------------------------------------------------------------------
+// Checks the pipeline library stage by stage on the host: the debouncer, each
+// axis filter, scaling, the response curves, the deadband, the trim engine and
+// the input-source scan steps. bench/pipeline_bench.cpp covers the full scan
+// (cost and a golden output checksum); these pin down each stage's contract.
+#include <unity.h>
+#include <QuadrantPipeline.h>
+#include "AxisTable.h"
+
+const FilterTuning TUNING = {ONE_EURO_MIN_ALPHA, ONE_EURO_BETA};
+const TrimTuning TRIM_TUNING = {256, TRIM_NOISE_COUNTS};
+
+void setUp() {}
+void tearDown() {}
+
+// -----------------------------------------------------------------------------
+// Button Debounce
+// -----------------------------------------------------------------------------
+void test_debounce_toggles_on_the_fourth_differing_sample()
+{
+  ButtonDebouncer debouncer;
+  debouncer.reset(0);
+  for (uint8_t i = 1; i < DEBOUNCE_SAMPLES; i++)
+  {
+    TEST_ASSERT_EQUAL_HEX32(0, debouncer.update(0x5));
+    TEST_ASSERT_EQUAL_HEX32(0, debouncer.state);
+  }
+  TEST_ASSERT_EQUAL_HEX32(0x5, debouncer.update(0x5));
+  TEST_ASSERT_EQUAL_HEX32(0x5, debouncer.state);
+  TEST_ASSERT_EQUAL_HEX32(0, debouncer.update(0x5)); // steady: no more toggles
+}
+
+void test_debounce_agreeing_sample_restarts_the_count()
+{
+  ButtonDebouncer debouncer;
+  debouncer.reset(0x1);
+  for (uint8_t i = 1; i < DEBOUNCE_SAMPLES; i++)
+  {
+    debouncer.update(0x0);
+  }
+  debouncer.update(0x1); // bounce back
+  for (uint8_t i = 1; i < DEBOUNCE_SAMPLES; i++)
+  {
+    TEST_ASSERT_EQUAL_HEX32(0, debouncer.update(0x0));
+  }
+  TEST_ASSERT_EQUAL_HEX32(0x1, debouncer.update(0x0));
+  TEST_ASSERT_EQUAL_HEX32(0x0, debouncer.state);
+}
+
+void test_debounce_buttons_count_independently()
+{
+  ButtonDebouncer debouncer;
+  debouncer.reset(0);
+  debouncer.update(0x1);
+  debouncer.update(0x1);
+  debouncer.update(0x3); // bit 1 starts two samples later
+  TEST_ASSERT_EQUAL_HEX32(0x1, debouncer.update(0x3));
+  debouncer.update(0x3);
+  TEST_ASSERT_EQUAL_HEX32(0x2, debouncer.update(0x3));
+  TEST_ASSERT_EQUAL_HEX32(0x3, debouncer.state);
+}
+
+// -----------------------------------------------------------------------------
+// Axis Filters
+// -----------------------------------------------------------------------------
+template <AxisFilter F>
+void assertPrimedAndSettles()
+{
+  AxisFilterState<F> filter;
+  filter.prime(1000);
+  TEST_ASSERT_EQUAL_INT(1000, filter.average());
+  for (int i = 0; i < 64; i++)
+  {
+    filter.push(3000, TUNING);
+  }
+  TEST_ASSERT_EQUAL_INT(3000, filter.average());
+}
+
+void test_filters_start_at_the_primed_value_and_settle_on_a_step()
+{
+  assertPrimedAndSettles<FILTER_BOXCAR>();
+  assertPrimedAndSettles<FILTER_EMA>();
+  assertPrimedAndSettles<FILTER_ONE_EURO>();
+  assertPrimedAndSettles<FILTER_MEDIAN3>();
+}
+
+void test_boxcar_averages_the_window()
+{
+  AxisFilterState<FILTER_BOXCAR> filter;
+  filter.prime(0);
+  for (int i = 0; i < filterWindowSize / 2; i++)
+  {
+    filter.push(800, TUNING);
+  }
+  TEST_ASSERT_EQUAL_INT(400, filter.average());
+  for (int i = 0; i < filterWindowSize / 2; i++)
+  {
+    filter.push(800, TUNING);
+  }
+  TEST_ASSERT_EQUAL_INT(800, filter.average());
+}
+
+void test_ema_moves_a_quarter_of_the_way_per_sample()
+{
+  AxisFilterState<FILTER_EMA> filter;
+  filter.prime(0);
+  filter.push(1024, TUNING);
+  TEST_ASSERT_EQUAL_INT(1024 >> EMA_SHIFT, filter.average());
+  int last = filter.average();
+  for (int i = 0; i < 8; i++)
+  {
+    filter.push(1024, TUNING);
+    TEST_ASSERT_TRUE(filter.average() >= last);
+    last = filter.average();
+  }
+}
+
+void test_one_euro_smooths_at_rest_and_follows_motion()
+{
+  // At rest, one step of noise moves the output by about the minimum alpha
+  AxisFilterState<FILTER_ONE_EURO> filter;
+  filter.prime(2000);
+  filter.push(2008, TUNING);
+  TEST_ASSERT_INT_WITHIN(1, 2001, filter.average());
+
+  // A large jump raises alpha, so it is followed much faster than an EMA
+  // with the resting alpha would follow it
+  filter.prime(0);
+  for (int i = 0; i < 4; i++)
+  {
+    filter.push(4000, TUNING);
+  }
+  TEST_ASSERT_TRUE(filter.average() > 3000);
+}
+
+void test_median3_rejects_a_single_spike()
+{
+  AxisFilterState<FILTER_MEDIAN3> filter;
+  filter.prime(500);
+  filter.push(4000, TUNING);
+  TEST_ASSERT_EQUAL_INT(500, filter.average());
+  filter.push(510, TUNING);
+  TEST_ASSERT_EQUAL_INT(510, filter.average());
+  filter.push(520, TUNING);
+  TEST_ASSERT_EQUAL_INT(520, filter.average());
+}
+
+// -----------------------------------------------------------------------------
+// Scaling, Curves and Deadband
+// -----------------------------------------------------------------------------
+void test_scale_axis_maps_the_calibrated_span_to_full_output()
+{
+  const int rawMin = 196 << ADC_OVERSAMPLE_BITS;
+  const int span = (1023 - 196) << ADC_OVERSAMPLE_BITS;
+  AxisCalibration calibration = {rawMin, scaleForSpan(clampAxisSpan(span))};
+  TEST_ASSERT_EQUAL_INT(0, scaleAxis(rawMin, calibration));
+  TEST_ASSERT_EQUAL_INT(0, scaleAxis(rawMin - 100, calibration));
+  TEST_ASSERT_INT_WITHIN(1, AXIS_OUTPUT_MAX / 2, scaleAxis(rawMin + span / 2, calibration));
+  TEST_ASSERT_EQUAL_INT(AXIS_OUTPUT_MAX, scaleAxis(rawMin + span, calibration));
+  TEST_ASSERT_EQUAL_INT(AXIS_OUTPUT_MAX, scaleAxis(AXIS_OUTPUT_MAX, calibration));
+}
+
+void test_scale_axis_clamps_tiny_spans()
+{
+  TEST_ASSERT_EQUAL_UINT32(64, clampAxisSpan(3));
+  AxisCalibration calibration = {100, scaleForSpan(clampAxisSpan(3))};
+  TEST_ASSERT_EQUAL_INT(AXIS_OUTPUT_MAX, scaleAxis(100 + 64, calibration));
+}
+
+void test_curves_span_full_travel_and_never_reverse()
+{
+  uint16_t userCurve[CURVE_POINTS];
+  for (uint8_t i = 0; i < CURVE_POINTS; i++)
+  {
+    userCurve[i] = ((uint32_t)i << CURVE_UNIT_BITS) / CURVE_SEGMENTS - (i == CURVE_SEGMENTS);
+  }
+  for (uint8_t curve = CURVE_LINEAR; curve <= CURVE_USER; curve++)
+  {
+    TEST_ASSERT_EQUAL_INT(0, applyCurve(curve, 0, userCurve));
+    TEST_ASSERT_EQUAL_INT(AXIS_OUTPUT_MAX, applyCurve(curve, AXIS_OUTPUT_MAX, userCurve));
+    int last = 0;
+    for (int value = 0; value <= AXIS_OUTPUT_MAX; value++)
+    {
+      int y = applyCurve(curve, value, userCurve);
+      TEST_ASSERT_TRUE(y >= last);
+      last = y;
+    }
+  }
+}
+
+void test_linear_user_curve_matches_the_input()
+{
+  uint16_t userCurve[CURVE_POINTS];
+  for (uint8_t i = 0; i < CURVE_POINTS; i++)
+  {
+    userCurve[i] = ((uint32_t)i << CURVE_UNIT_BITS) / CURVE_SEGMENTS - (i == CURVE_SEGMENTS);
+  }
+  for (int value = 0; value <= AXIS_OUTPUT_MAX; value += 7)
+  {
+    TEST_ASSERT_INT_WITHIN(2, value, applyCurve(CURVE_USER, value, userCurve));
+  }
+}
+
+void test_curve_hits_the_user_breakpoints()
+{
+  uint16_t userCurve[CURVE_POINTS];
+  for (uint8_t i = 0; i < CURVE_POINTS; i++)
+  {
+    userCurve[i] = i < CURVE_POINTS / 2 ? 0 : 4095; // a step at half travel
+  }
+  TEST_ASSERT_EQUAL_INT(0, applyCurve(CURVE_USER, AXIS_OUTPUT_MAX / 4, userCurve));
+  TEST_ASSERT_EQUAL_INT(AXIS_OUTPUT_MAX, applyCurve(CURVE_USER, AXIS_OUTPUT_MAX * 3 / 4, userCurve));
+}
+
+void test_deadband_holds_small_changes()
+{
+  int stable = 1000;
+  TEST_ASSERT_EQUAL_INT(1000, applyDeadband(1003, stable, 4));
+  TEST_ASSERT_EQUAL_INT(1000, applyDeadband(997, stable, 4));
+  TEST_ASSERT_EQUAL_INT(1004, applyDeadband(1004, stable, 4));
+  TEST_ASSERT_EQUAL_INT(1004, stable);
+  TEST_ASSERT_EQUAL_INT(1000, applyDeadband(1000, stable, 4));
+  TEST_ASSERT_EQUAL_INT(1001, applyDeadband(1001, stable, 0)); // 0 = off
+}
+
+// -----------------------------------------------------------------------------
+// Virtual Trim
+// -----------------------------------------------------------------------------
+const int TRIM_SPAN = (1023 - 196) << ADC_OVERSAMPLE_BITS;
+
+void test_trim_ignores_noise()
+{
+  TrimEngine trim;
+  trim.prime(2000, 0, TRIM_Q_MID);
+  TEST_ASSERT_FALSE(trim.update(2000 + TRIM_NOISE_COUNTS - 1, 1000, TRIM_SPAN, TRIM_TUNING));
+  TEST_ASSERT_EQUAL_INT32(TRIM_Q_MID, trim.accumulated);
+  TEST_ASSERT_TRUE(trim.update(2000 + TRIM_NOISE_COUNTS, 2000, TRIM_SPAN, TRIM_TUNING));
+  TEST_ASSERT_TRUE(trim.accumulated > TRIM_Q_MID);
+}
+
+void test_trim_unwraps_steps_past_the_end_of_travel()
+{
+  // From near the top to near the bottom is a small step up, not a big one down
+  TrimEngine trim;
+  trim.prime(TRIM_SPAN - 8, 0, TRIM_Q_MID);
+  TEST_ASSERT_TRUE(trim.update(8, 10000, TRIM_SPAN, TRIM_TUNING));
+  TEST_ASSERT_TRUE(trim.accumulated > TRIM_Q_MID);
+
+  trim.prime(8, 0, TRIM_Q_MID);
+  TEST_ASSERT_TRUE(trim.update(TRIM_SPAN - 8, 10000, TRIM_SPAN, TRIM_TUNING));
+  TEST_ASSERT_TRUE(trim.accumulated < TRIM_Q_MID);
+}
+
+void test_trim_gain_rises_with_speed_and_scales()
+{
+  TEST_ASSERT_EQUAL_UINT16(TRIM_ACCEL_CURVE[0], trimGain(1, 100000));  // crawling
+  TEST_ASSERT_EQUAL_UINT16(TRIM_ACCEL_CURVE[TRIM_ACCEL_STEPS - 1], trimGain(1000, 1000)); // spinning
+  TEST_ASSERT_EQUAL_UINT16(TRIM_ACCEL_CURVE[TRIM_ACCEL_STEPS - 1], trimGain(10, 0));
+  uint16_t last = 0;
+  for (unsigned long dt = 100000; dt >= 10; dt /= 2)
+  {
+    uint16_t gain = trimGain(16, dt);
+    TEST_ASSERT_TRUE(gain >= last);
+    last = gain;
+  }
+
+  // The same step with gainScale doubled moves the accumulator twice as far
+  const TrimTuning doubled = {512, TRIM_NOISE_COUNTS};
+  TrimEngine normal, fast;
+  normal.prime(1000, 0, TRIM_Q_MID);
+  fast.prime(1000, 0, TRIM_Q_MID);
+  normal.update(1040, 20000, TRIM_SPAN, TRIM_TUNING);
+  fast.update(1040, 20000, TRIM_SPAN, doubled);
+  TEST_ASSERT_EQUAL_INT32(2 * (normal.accumulated - TRIM_Q_MID), fast.accumulated - TRIM_Q_MID);
+}
+
+void test_trim_clamps_at_both_ends()
+{
+  TrimEngine trim;
+  trim.prime(0, 0, TRIM_Q_MAX - 1);
+  unsigned long us = 0;
+  int raw = 0;
+  for (int i = 0; i < 50; i++)
+  {
+    raw += 200;
+    us += 1000;
+    trim.update(raw % TRIM_SPAN, us, TRIM_SPAN, TRIM_TUNING);
+  }
+  TEST_ASSERT_EQUAL_INT32(TRIM_Q_MAX, trim.accumulated);
+  TEST_ASSERT_EQUAL_INT(AXIS_OUTPUT_MAX, trim.output());
+
+  trim.prime(TRIM_SPAN / 2, 0, 0);
+  TEST_ASSERT_TRUE(trim.update(TRIM_SPAN / 2 - 100, 1000, TRIM_SPAN, TRIM_TUNING));
+  TEST_ASSERT_EQUAL_INT32(0, trim.accumulated);
+}
+
+// -----------------------------------------------------------------------------
+// Input Sources
+// -----------------------------------------------------------------------------
+struct FakeAxisSource
+{
+  int samples[4];
+  uint8_t count;
+  uint8_t next;
+
+  bool take(uint8_t, int &sample)
+  {
+    if (next == count)
+      return false;
+    sample = samples[next++];
+    return true;
+  }
+};
+
+struct FakeButtonSource
+{
+  uint16_t pressed[3];
+  uint8_t failing; // bit n: chip n does not answer
+
+  bool read(uint8_t chip, uint16_t &out)
+  {
+    if ((failing >> chip) & 1)
+      return false;
+    out = pressed[chip];
+    return true;
+  }
+};
+
+void test_drain_axis_feeds_every_sample_and_keeps_the_latest()
+{
+  FakeAxisSource source = {{100, 200, 300, 400}, 4, 0};
+  AxisFilterState<FILTER_MEDIAN3> filter;
+  filter.prime(0);
+  int latest = -1;
+  TEST_ASSERT_TRUE(drainAxis(source, 0, filter, TUNING, latest));
+  TEST_ASSERT_EQUAL_INT(400, latest);
+  TEST_ASSERT_EQUAL_INT(300, filter.average());
+  TEST_ASSERT_FALSE(drainAxis(source, 0, filter, TUNING, latest));
+  TEST_ASSERT_EQUAL_INT(400, latest);
+}
+
+void test_sample_buttons_packs_chips_and_holds_failed_ones()
+{
+  ButtonDebouncer debouncers[2];
+  debouncers[0].reset(0xBEEF0000UL); // chip 1 was reading 0xBEEF
+  debouncers[1].reset(0);
+  FakeButtonSource source = {{0x1234, 0x5678, 0x9ABC}, 0x2};
+  uint32_t words[2] = {0, 0};
+  sampleButtons(source, 3, debouncers, words);
+  TEST_ASSERT_EQUAL_HEX32(0xBEEF1234UL, words[0]);
+  TEST_ASSERT_EQUAL_HEX32(0x00009ABCUL, words[1]);
+}
+
+// -----------------------------------------------------------------------------
+// Axis Table
+// -----------------------------------------------------------------------------
+void test_axis_table_defaults_are_valid()
+{
+  for (uint8_t i = 0; i < NUM_AXES; i++)
+  {
+    AxisDescriptor axis = axisDescriptor(i);
+    TEST_ASSERT_TRUE(axis.rawMax > axis.rawMin);
+    TEST_ASSERT_TRUE(axis.curve <= CURVE_USER);
+    TEST_ASSERT_TRUE(axis.deadband <= AXIS_OUTPUT_MAX);
+  }
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_debounce_toggles_on_the_fourth_differing_sample);
+  RUN_TEST(test_debounce_agreeing_sample_restarts_the_count);
+  RUN_TEST(test_debounce_buttons_count_independently);
+  RUN_TEST(test_filters_start_at_the_primed_value_and_settle_on_a_step);
+  RUN_TEST(test_boxcar_averages_the_window);
+  RUN_TEST(test_ema_moves_a_quarter_of_the_way_per_sample);
+  RUN_TEST(test_one_euro_smooths_at_rest_and_follows_motion);
+  RUN_TEST(test_median3_rejects_a_single_spike);
+  RUN_TEST(test_scale_axis_maps_the_calibrated_span_to_full_output);
+  RUN_TEST(test_scale_axis_clamps_tiny_spans);
+  RUN_TEST(test_curves_span_full_travel_and_never_reverse);
+  RUN_TEST(test_linear_user_curve_matches_the_input);
+  RUN_TEST(test_curve_hits_the_user_breakpoints);
+  RUN_TEST(test_deadband_holds_small_changes);
+  RUN_TEST(test_trim_ignores_noise);
+  RUN_TEST(test_trim_unwraps_steps_past_the_end_of_travel);
+  RUN_TEST(test_trim_gain_rises_with_speed_and_scales);
+  RUN_TEST(test_trim_clamps_at_both_ends);
+  RUN_TEST(test_drain_axis_feeds_every_sample_and_keeps_the_latest);
+  RUN_TEST(test_sample_buttons_packs_chips_and_holds_failed_ones);
+  RUN_TEST(test_axis_table_defaults_are_valid);
+  return UNITY_END();
+}
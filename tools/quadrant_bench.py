@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""Host-side benchmark for the MoonDog Throttle Quadrant.
+
+Flash the `leonardo_bench` environment, jumper the loopback pin (Leonardo
+pin 5) to button 31 (mcp2 GPB7), then run:
+
+    python tools/quadrant_bench.py --port COM5
+
+Measures, from raw HID input reports:
+  * press-to-report latency: time from writing 'p' on the CDC port until a
+    report with the loopback button pressed arrives (includes one USB OUT
+    transfer, so expect up to ~1 ms of host/USB overhead on top)
+  * report rate and jitter while the firmware toggles the loopback pin
+
+Requires: pip install hidapi pyserial
+"""
+
+import argparse
+import statistics
+import sys
+import threading
+import time
+
+import hid
+import serial
+
+LEONARDO_VID = 0x2341
+LEONARDO_PID = 0x8036
+
+
+class ReportReader(threading.Thread):
+    """Collects (host timestamp, report bytes) for every HID input report."""
+
+    def __init__(self, device):
+        super().__init__(daemon=True)
+        self.device = device
+        self.reports = []
+        self.lock = threading.Lock()
+        self.cond = threading.Condition(self.lock)
+        self.running = True
+
+    def run(self):
+        while self.running:
+            data = self.device.read(64, 100)
+            if data:
+                now = time.perf_counter()
+                with self.cond:
+                    self.reports.append((now, bytes(data)))
+                    self.cond.notify_all()
+
+    def wait_for(self, predicate, since, timeout):
+        """Return the timestamp of the first report after `since` matching predicate."""
+        deadline = time.perf_counter() + timeout
+        with self.cond:
+            while True:
+                for stamp, data in self.reports:
+                    if stamp >= since and predicate(data):
+                        return stamp
+                remaining = deadline - time.perf_counter()
+                if remaining <= 0:
+                    return None
+                self.cond.wait(remaining)
+
+    def take(self):
+        with self.lock:
+            reports, self.reports = self.reports, []
+        return reports
+
+
+def open_hid(vid, pid, usage=None):
+    for info in hid.enumerate(vid, pid):
+        if usage is not None and info.get("usage") not in (None, 0, usage):
+            continue
+        if info.get("usage_page") in (None, 0, 1):
+            device = hid.device()
+            device.open_path(info["path"])
+            return device
+    sys.exit("No HID device %04x:%04x found" % (vid, pid))
+
+
+def button_pressed(data, report_id, button):
+    if report_id is not None:
+        if data[0] != report_id:
+            return None
+        data = data[1:]
+    return bool(data[button // 8] & (1 << (button % 8)))
+
+
+def summarize(name, values, unit="ms"):
+    if not values:
+        print("%-10s no samples" % name)
+        return
+    values = sorted(values)
+    pick = lambda q: values[min(len(values) - 1, int(q * len(values)))]
+    print("%-10s n=%d min=%.3f mean=%.3f p50=%.3f p95=%.3f p99=%.3f max=%.3f %s" % (
+        name, len(values), values[0], statistics.mean(values), pick(0.5),
+        pick(0.95), pick(0.99), values[-1], unit))
+
+
+def measure_latency(port, reader, args):
+    latencies = []
+    is_pressed = lambda d: button_pressed(d, args.report_id, args.button) is True
+    is_released = lambda d: button_pressed(d, args.report_id, args.button) is False
+    for _ in range(args.samples):
+        reader.take()
+        start = time.perf_counter()
+        port.write(b"p")
+        port.flush()
+        stamp = reader.wait_for(is_pressed, start, 1.0)
+        if stamp is not None:
+            latencies.append((stamp - start) * 1000.0)
+        port.write(b"u")
+        port.flush()
+        reader.wait_for(is_released, time.perf_counter(), 1.0)
+        time.sleep(args.gap_ms / 1000.0)
+    summarize("latency", latencies)
+    return latencies
+
+
+def measure_rate(port, reader, args):
+    reader.take()
+    port.write(b"w")
+    port.flush()
+    time.sleep(args.rate_seconds)
+    port.write(b"w")
+    port.flush()
+    reports = reader.take()
+    if len(reports) < 2:
+        print("rate       too few reports (%d)" % len(reports))
+        return
+    span = reports[-1][0] - reports[0][0]
+    intervals = [(b[0] - a[0]) * 1000.0 for a, b in zip(reports, reports[1:])]
+    print("rate       %.1f reports/s over %.1f s" % ((len(reports) - 1) / span, span))
+    summarize("interval", intervals)
+    print("jitter     stdev=%.3f ms" % statistics.pstdev(intervals))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", required=True, help="CDC serial port (e.g. COM5, /dev/ttyACM0)")
+    parser.add_argument("--vid", type=lambda v: int(v, 0), default=LEONARDO_VID)
+    parser.add_argument("--pid", type=lambda v: int(v, 0), default=LEONARDO_PID)
+    parser.add_argument("--report-id", type=lambda v: int(v, 0), default=3,
+                        help="report ID carrying the buttons (default 3, JOYSTICK_DEFAULT_REPORT_ID; "
+                             "4 with QUADRANT_SPLIT_REPORTS)")
+    parser.add_argument("--usage", type=lambda v: int(v, 0), default=None,
+                        help="HID collection usage to open when there are several "
+                             "(0x05, the gamepad, for the split-report buttons)")
+    parser.add_argument("--button", type=int, default=31, help="button wired to the loopback pin")
+    parser.add_argument("--samples", type=int, default=200)
+    parser.add_argument("--gap-ms", type=float, default=20.0, help="idle time between presses")
+    parser.add_argument("--rate-seconds", type=float, default=5.0)
+    args = parser.parse_args()
+
+    device = open_hid(args.vid, args.pid, args.usage)
+    reader = ReportReader(device)
+    reader.start()
+    with serial.Serial(args.port, 9600, timeout=0) as port:
+        time.sleep(0.2)
+        port.reset_input_buffer()
+        measure_latency(port, reader, args)
+        measure_rate(port, reader, args)
+    reader.running = False
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+"""Input capture and replay for the MoonDog Throttle Quadrant.
+
+Records the raw samples the firmware pipeline consumes (every ADC sample and
+every change of the raw button words, timestamped) to a CSV file, and plays
+such a file back into the firmware in place of the real pots and expanders:
+
+    python tools/quadrant_capture.py --port COM5 record capture.csv --seconds 30
+    python tools/quadrant_capture.py --port COM5 replay capture.csv
+    python tools/quadrant_capture.py --port COM5 replay capture.csv --record out.csv
+
+Replay keeps the recorded timing (scaled by --speed). With --record the
+device records while it replays, so out.csv shows what the pipeline
+consumed; the HID reports meanwhile come from the replayed input.
+--file decodes a saved raw byte stream instead of a port.
+Requires: pip install pyserial
+"""
+
+import argparse
+import csv
+import sys
+import time
+
+from quadrant_params import (CMD_RECORD, CMD_REPLAY, STATUS_TEXT, Channel,
+                             build_request, checksum, parse_response)
+
+RECORD_SYNC = b"\xa5\x5b"
+RECORD_FRAME_SIZE = 14
+RECORD_BUTTONS = 0x80
+CMD_REPLAY_SAMPLE = 0x07
+
+
+def source_name(source):
+    if source >= RECORD_BUTTONS:
+        return "buttons%d" % (source - RECORD_BUTTONS)
+    return "axis%d" % source
+
+
+def parse_source(name):
+    if name.startswith("buttons"):
+        return RECORD_BUTTONS + int(name[7:])
+    if name.startswith("axis"):
+        return int(name[4:])
+    return int(name, 0)
+
+
+class RecordDecoder:
+    """Incremental record frame decoder; skips anything that is not one."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.last_seq = None
+        self.events = 0
+        self.lost = 0
+        self.bad = 0
+
+    def feed(self, data):
+        self.buffer.extend(data)
+        events = []
+        while True:
+            start = self.buffer.find(RECORD_SYNC)
+            if start < 0:
+                del self.buffer[:-1]
+                return events
+            del self.buffer[:start]
+            if len(self.buffer) < RECORD_FRAME_SIZE:
+                return events
+            frame = bytes(self.buffer[:RECORD_FRAME_SIZE])
+            if bytes(checksum(frame[2:12])) != frame[12:14]:
+                self.bad += 1
+                del self.buffer[:1]
+                continue
+            del self.buffer[:RECORD_FRAME_SIZE]
+
+            seq, source = frame[2], frame[3]
+            us = int.from_bytes(frame[4:8], "little")
+            value = int.from_bytes(frame[8:12], "little")
+            if self.last_seq is not None:
+                self.lost += (seq - self.last_seq - 1) & 0xFF
+            self.last_seq = seq
+            self.events += 1
+            events.append((us, source, value))
+
+
+class CaptureLog:
+    """Writes events as t_us (relative, unwrapped), source, value."""
+
+    def __init__(self, path):
+        self.file = open(path, "w", newline="")
+        self.writer = csv.writer(self.file)
+        self.writer.writerow(["t_us", "source", "value"])
+        self.first = None
+        self.last = None
+        self.offset = 0
+
+    def write(self, events):
+        for us, source, value in events:
+            if self.first is None:
+                self.first = self.last = us
+            if us < self.last and self.last - us > 1 << 31:
+                self.offset += 1 << 32  # micros() wrapped
+            self.last = us
+            value_text = "0x%08x" % value if source >= RECORD_BUTTONS else str(value)
+            self.writer.writerow([us + self.offset - self.first, source_name(source), value_text])
+
+    def close(self):
+        self.file.close()
+
+
+def read_capture(path):
+    with open(path, newline="") as source:
+        return [(int(row["t_us"]), parse_source(row["source"]), int(row["value"], 0))
+                for row in csv.DictReader(source)]
+
+
+def drain(port, decoder, log, buffer):
+    """Read what the device sent; log record frames, report replay errors."""
+    data = port.read(4096)
+    if not data:
+        return buffer
+    if log:
+        log.write(decoder.feed(data))
+    buffer += data
+    while True:
+        response, buffer = parse_response(buffer)
+        if not response:
+            return buffer
+        cmd, status, param, value = response
+        if cmd == CMD_REPLAY_SAMPLE and status:
+            print("replay sample %s=%d: %s" % (source_name(param), value, STATUS_TEXT.get(status, status)),
+                  file=sys.stderr)
+
+
+def record(port, args):
+    channel = Channel(port)
+    decoder = RecordDecoder()
+    log = CaptureLog(args.capture)
+    channel.request(CMD_RECORD, 0, 1)
+    log.write(decoder.feed(channel.buffer))
+    deadline = time.monotonic() + args.seconds if args.seconds else None
+    try:
+        while deadline is None or time.monotonic() < deadline:
+            data = port.read(4096)
+            if data:
+                log.write(decoder.feed(data))
+    except KeyboardInterrupt:
+        pass
+    finally:
+        port.write(build_request(CMD_RECORD, 0, 0))
+        port.flush()
+        log.close()
+    return decoder
+
+
+def replay(port, args):
+    events = read_capture(args.capture)
+    channel = Channel(port)
+    decoder = RecordDecoder()
+    log = CaptureLog(args.record) if args.record else None
+    if log:
+        channel.request(CMD_RECORD, 0, 1)
+    channel.request(CMD_REPLAY, 0, 1)
+    buffer = b""
+    start = time.perf_counter()
+    try:
+        for t_us, source, value in events:
+            due = start + t_us / 1e6 / args.speed
+            while time.perf_counter() < due:
+                buffer = drain(port, decoder, log, buffer)
+            port.write(build_request(CMD_REPLAY_SAMPLE, source, value))
+        time.sleep(0.1)
+        buffer = drain(port, decoder, log, buffer)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        port.write(build_request(CMD_REPLAY, 0, 0))
+        if log:
+            port.write(build_request(CMD_RECORD, 0, 0))
+        port.flush()
+        if log:
+            log.close()
+    print("replayed %d events in %.1f s" % (len(events), time.perf_counter() - start), file=sys.stderr)
+    return decoder
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="CDC serial port (e.g. COM5, /dev/ttyACM0)")
+    source.add_argument("--file", help="decode a saved raw byte stream (record only)")
+    sub = parser.add_subparsers(dest="command", required=True)
+    rec = sub.add_parser("record", help="capture raw input to a CSV file")
+    rec.add_argument("capture")
+    rec.add_argument("--seconds", type=float, help="stop after this long (default: Ctrl+C)")
+    rep = sub.add_parser("replay", help="feed a capture into the firmware")
+    rep.add_argument("capture")
+    rep.add_argument("--speed", type=float, default=1.0, help="playback speed factor")
+    rep.add_argument("--record", help="record what the device consumed to this CSV")
+    args = parser.parse_args()
+
+    if args.file:
+        if args.command != "record":
+            sys.exit("--file only works with record")
+        decoder = RecordDecoder()
+        log = CaptureLog(args.capture)
+        with open(args.file, "rb") as raw:
+            log.write(decoder.feed(raw.read()))
+        log.close()
+    else:
+        import serial
+
+        with serial.Serial(args.port, 9600, timeout=0.005) as port:
+            time.sleep(0.2)
+            port.reset_input_buffer()
+            decoder = record(port, args) if args.command == "record" else replay(port, args)
+    print("events=%d lost=%d bad=%d" % (decoder.events, decoder.lost, decoder.bad), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
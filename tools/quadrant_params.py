@@ -0,0 +1,223 @@
+#!/usr/bin/env python3
+"""Live parameter access for the MoonDog Throttle Quadrant.
+
+Reads and writes the firmware's runtime parameters over the binary command
+channel on the CDC serial port, without a rebuild or reflash:
+
+    python tools/quadrant_params.py --port COM5 list
+    python tools/quadrant_params.py --port COM5 get axis_scan_us
+    python tools/quadrant_params.py --port COM5 set deadband.0 8
+    python tools/quadrant_params.py --port COM5 set curve.3 2     # S-curve on axis 3
+    python tools/quadrant_params.py --port COM5 curve 0:0 0.5:0.3 1:1
+    python tools/quadrant_params.py --port COM5 commit     # keep across power cycles
+    python tools/quadrant_params.py --port COM5 defaults   # back to the build defaults
+
+Changes take effect on the next scan and are lost at power-off unless
+committed. Requires: pip install pyserial
+"""
+
+import argparse
+import sys
+import time
+
+COMMAND_SYNC = 0xA5
+RESPONSE_SYNC = b"\xa5\x5c"
+RESPONSE_SIZE = 11
+
+CMD_GET, CMD_SET, CMD_COMMIT, CMD_DEFAULTS = 0x01, 0x02, 0x03, 0x04
+CMD_RECORD, CMD_REPLAY = 0x05, 0x06  # used by quadrant_capture.py
+CMD_APPLY_CURVE = 0x08
+
+STATUS_TEXT = {
+    0: "ok",
+    1: "unknown parameter",
+    2: "out of range",
+    3: "bad checksum",
+    4: "unknown command",
+    5: "busy (EEPROM commit in progress)",
+    6: "no replay running",
+}
+
+# name -> (id, description); mirrors PARAM_TABLE in src/main.cpp
+PARAMS = {
+    "axis_scan_us": (0x01, "axis scan period, us"),
+    "button_scan_us": (0x02, "button scan / debounce sample period, us"),
+    "keepalive_ms": (0x03, "unchanged-report keepalive, ms (0 = off)"),
+    "axis_report_us": (0x04, "minimum interval between reports of one axis, us"),
+    "one_euro_min_alpha": (0x05, "One-Euro smoothing at rest, Q8"),
+    "one_euro_beta": (0x06, "One-Euro alpha added per count of lag"),
+    "trim_gain": (0x07, "trim gain multiplier, Q8 (256 = curve as built)"),
+    "trim_noise": (0x08, "trim step threshold, ADC counts"),
+    "sync_tolerance": (0x09, "throttle L/R lock when this close, output counts (0 = off)"),
+    "sync_release": (0x0A, "throttle L/R unlock when this far apart, output counts"),
+    "idle_timeout_ms": (0x0B, "untouched this long drops to the idle scan rate, ms (0 = never)"),
+    "idle_scan_us": (0x0C, "axis and button scan period while idle, us"),
+    "idle_keepalive_ms": (0x0D, "unchanged-report keepalive while idle, ms (0 = off)"),
+    "idle_wake_counts": (0x0E, "ADC movement from rest that wakes from idle, sample counts"),
+}
+DEADBAND_ID = 0x10
+CURVE_ID = 0x20
+USER_CURVE_ID = 0x40
+STAGED_CURVE_ID = 0x80  # upload target; CMD_APPLY_CURVE makes it live
+MAX_AXES = 16
+CURVE_POINTS = 33
+CURVE_MAX = 4095
+CURVE_NAMES = ["linear", "expo", "s", "detents", "user"]
+INDEXED = {"deadband": (DEADBAND_ID, MAX_AXES), "curve": (CURVE_ID, MAX_AXES),
+           "user_curve": (USER_CURVE_ID, CURVE_POINTS)}
+
+
+def checksum(data):
+    sum1 = sum2 = 0
+    for byte in data:
+        sum1 = (sum1 + byte) & 0xFF
+        sum2 = (sum2 + sum1) & 0xFF
+    return bytes((sum1, sum2))
+
+
+def build_request(cmd, param=0, value=0):
+    body = bytes((cmd, param)) + (value & 0xFFFFFFFF).to_bytes(4, "little")
+    return bytes((COMMAND_SYNC,)) + body + checksum(body)
+
+
+def parse_response(buffer):
+    """Return (response, rest). response is (cmd, status, param, value) or None."""
+    while True:
+        start = buffer.find(RESPONSE_SYNC)
+        if start < 0:
+            return None, buffer[-1:]
+        buffer = buffer[start:]
+        if len(buffer) < RESPONSE_SIZE:
+            return None, buffer
+        frame = buffer[:RESPONSE_SIZE]
+        if checksum(frame[2:9]) != frame[9:11]:
+            buffer = buffer[1:]
+            continue
+        value = int.from_bytes(frame[5:9], "little", signed=True)
+        return (frame[2], frame[3], frame[4], value), buffer[RESPONSE_SIZE:]
+
+
+def param_id(name):
+    base, _, index = name.partition(".")
+    if index and base in INDEXED:
+        first, count = INDEXED[base]
+        if not 0 <= int(index) < count:
+            sys.exit("index out of range")
+        return first + int(index)
+    if name not in PARAMS:
+        sys.exit("unknown parameter %r (try 'list')" % name)
+    return PARAMS[name][0]
+
+
+class Channel:
+    def __init__(self, port, timeout=0.5):
+        self.port = port
+        self.timeout = timeout
+        self.buffer = b""
+
+    def request(self, cmd, param=0, value=0, retries=3):
+        for _ in range(retries):
+            self.port.write(build_request(cmd, param, value))
+            self.port.flush()
+            deadline = time.monotonic() + self.timeout
+            while time.monotonic() < deadline:
+                self.buffer += self.port.read(256)
+                response, self.buffer = parse_response(self.buffer)
+                if response and response[0] == cmd and response[2] == param:
+                    return response
+        sys.exit("no response from the device")
+
+
+def parse_value(text):
+    """Integer, or a curve name for curve.N."""
+    if text.lower() in CURVE_NAMES:
+        return CURVE_NAMES.index(text.lower())
+    return int(text, 0)
+
+
+def curve_points(breakpoints):
+    """Interpolate 'x:y' breakpoints (0..1) to the firmware's evenly spaced table."""
+    pairs = sorted(tuple(float(v) for v in point.split(":")) for point in breakpoints)
+    if len(pairs) < 2 or pairs[0][0] > 0 or pairs[-1][0] < 1:
+        sys.exit("breakpoints must span x = 0 to 1")
+    table = []
+    for i in range(CURVE_POINTS):
+        x = i / (CURVE_POINTS - 1)
+        for (x0, y0), (x1, y1) in zip(pairs, pairs[1:]):
+            if x0 <= x <= x1:
+                y = y0 if x1 == x0 else y0 + (y1 - y0) * (x - x0) / (x1 - x0)
+                break
+        table.append(min(CURVE_MAX, max(0, round(y * CURVE_MAX))))
+    return table
+
+
+def report(name, response):
+    _, status, _, value = response
+    if status:
+        print("%-20s %s (value %d)" % (name, STATUS_TEXT.get(status, status), value))
+    else:
+        print("%-20s %d" % (name, value))
+    return status
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", required=True, help="CDC serial port (e.g. COM5, /dev/ttyACM0)")
+    sub = parser.add_subparsers(dest="command", required=True)
+    sub.add_parser("list", help="read every parameter")
+    get = sub.add_parser("get", help="read one parameter")
+    get.add_argument("name")
+    put = sub.add_parser("set", help="write one parameter")
+    put.add_argument("name")
+    put.add_argument("value", type=parse_value)
+    curve = sub.add_parser("curve", help="upload the user curve (select it with set curve.N user)")
+    curve.add_argument("points", nargs="+", metavar="X:Y", help="breakpoints, 0..1 each")
+    sub.add_parser("commit", help="save the live parameters to EEPROM")
+    sub.add_parser("defaults", help="restore the build defaults (then commit to keep)")
+    args = parser.parse_args()
+
+    import serial
+
+    with serial.Serial(args.port, 9600, timeout=0.02) as port:
+        time.sleep(0.2)
+        port.reset_input_buffer()
+        channel = Channel(port)
+
+        status = 0
+        if args.command == "list":
+            for name, (pid, description) in PARAMS.items():
+                report(name, channel.request(CMD_GET, pid))
+                print("%-20s   %s" % ("", description))
+            for axis in range(MAX_AXES):
+                response = channel.request(CMD_GET, DEADBAND_ID + axis)
+                if response[1] == 1:
+                    break  # past the last axis
+                report("deadband.%d" % axis, response)
+                report("curve.%d" % axis, channel.request(CMD_GET, CURVE_ID + axis))
+        elif args.command == "get":
+            status = report(args.name, channel.request(CMD_GET, param_id(args.name)))
+        elif args.command == "set":
+            status = report(args.name, channel.request(CMD_SET, param_id(args.name), args.value))
+        elif args.command == "curve":
+            # Stage every point, then swap the whole curve in with one command,
+            # so no axis ever runs a mix of the old and new curves
+            for i, y in enumerate(curve_points(args.points)):
+                _, status, _, _ = channel.request(CMD_SET, STAGED_CURVE_ID + i, y)
+                if status:
+                    print("user_curve.%d: %s (live curve unchanged)" % (i, STATUS_TEXT.get(status, status)))
+                    break
+            else:
+                _, status, _, _ = channel.request(CMD_APPLY_CURVE)
+                print("user curve: %s" % (STATUS_TEXT.get(status, status) if status
+                                          else "applied (commit to keep)"))
+        elif args.command == "commit":
+            _, status, _, value = channel.request(CMD_COMMIT)
+            print("commit: %s" % (STATUS_TEXT.get(status, status) if status else "%d bytes queued" % value))
+        elif args.command == "defaults":
+            _, status, _, _ = channel.request(CMD_DEFAULTS)
+            print("defaults: %s" % STATUS_TEXT.get(status, status))
+    sys.exit(1 if status else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+"""Binary telemetry decoder for the MoonDog Throttle Quadrant.
+
+Switches the firmware to binary telemetry ('b') and decodes one frame per
+axis scan:
+
+    python tools/quadrant_telemetry.py --port COM5             # live table
+    python tools/quadrant_telemetry.py --port COM5 --csv log.csv
+    python tools/quadrant_telemetry.py --file capture.bin --csv log.csv
+
+The live table is the view the firmware used to draw itself over serial;
+it is redrawn at --fps while every frame is still decoded and logged.
+--raw-out saves the undecoded byte stream for later --file runs.
+
+Requires: pip install pyserial
+"""
+
+import argparse
+import csv
+import sys
+import time
+
+SYNC = b"\xa5\x5a"
+HEADER_SIZE = 5  # sync, seq, axis count, button word count
+BUTTON_WORD_SIZE = 4
+AXIS_SIZE = 6
+CHECKSUM_SIZE = 2
+
+DEFAULT_LABELS = ["Throttle L", "Throttle R", "Trim", "Mixture 1",
+                  "Mixture 2", "TBD Axis", "Axis 7"]
+
+
+def frame_size(axis_count, button_words):
+    return HEADER_SIZE + BUTTON_WORD_SIZE * button_words + AXIS_SIZE * axis_count + CHECKSUM_SIZE
+
+
+def checksum(data):
+    sum1 = sum2 = 0
+    for byte in data:
+        sum1 = (sum1 + byte) & 0xFF
+        sum2 = (sum2 + sum1) & 0xFF
+    return sum1, sum2
+
+
+def unpack_pair12(data, offset):
+    word = data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16)
+    return word & 0xFFF, word >> 12
+
+
+class Frame:
+    __slots__ = ("seq", "buttons", "axes", "host_time")
+
+    def __init__(self, seq, buttons, axes, host_time):
+        self.seq = seq
+        self.buttons = buttons  # int, bit n = button n
+        self.axes = axes  # [(raw, average, mapped, stable), ...]
+        self.host_time = host_time
+
+
+class Decoder:
+    """Incremental frame decoder; resynchronises on the sync word."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.last_seq = None
+        self.frames = 0
+        self.lost = 0
+        self.bad = 0
+
+    def feed(self, data, host_time=None):
+        self.buffer.extend(data)
+        frames = []
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                del self.buffer[:-1]  # keep a possible first sync byte
+                return frames
+            del self.buffer[:start]
+            if len(self.buffer) < HEADER_SIZE:
+                return frames
+            size = frame_size(self.buffer[3], self.buffer[4])
+            if len(self.buffer) < size:
+                return frames
+
+            body = bytes(self.buffer[2:size - CHECKSUM_SIZE])
+            if checksum(body) != tuple(self.buffer[size - CHECKSUM_SIZE:size]):
+                self.bad += 1
+                del self.buffer[:1]  # false sync or corrupt frame
+                continue
+            del self.buffer[:size]
+            frames.append(self._decode(body, host_time))
+
+    def _decode(self, body, host_time):
+        seq, axis_count, button_words = body[0], body[1], body[2]
+        axes_start = 3 + BUTTON_WORD_SIZE * button_words
+        buttons = int.from_bytes(body[3:axes_start], "little")  # button n = bit n
+        axes = []
+        for i in range(axis_count):
+            offset = axes_start + i * AXIS_SIZE
+            raw, average = unpack_pair12(body, offset)
+            mapped, stable = unpack_pair12(body, offset + 3)
+            axes.append((raw, average, mapped, stable))
+
+        if self.last_seq is not None:
+            self.lost += (seq - self.last_seq - 1) & 0xFF
+        self.last_seq = seq
+        self.frames += 1
+        return Frame(seq, buttons, axes, host_time)
+
+
+RULE = "─" * 77
+
+
+def render_table(frame, labels, decoder):
+    lines = ["\033[2J\033[H" + RULE,
+             "  Axis         Raw    Smoothed    Mapped     ΔMapped",
+             RULE]
+    for i, (raw, average, mapped, stable) in enumerate(frame.axes):
+        label = labels[i] if i < len(labels) else "Axis %d" % (i + 1)
+        lines.append("  %-10s  |  %4d  |    %4d     |   %4d     |     %d" % (
+            label, raw, average, mapped, abs(mapped - stable)))
+    lines.append(RULE)
+    pressed = [str(b) for b in range(frame.buttons.bit_length()) if frame.buttons & (1 << b)]
+    lines.append("  buttons: %s" % (" ".join(pressed) or "-"))
+    lines.append("  frames=%d lost=%d bad=%d" % (decoder.frames, decoder.lost, decoder.bad))
+    sys.stdout.write("\r\n".join(lines) + "\r\n")
+    sys.stdout.flush()
+
+
+class CsvLog:
+    def __init__(self, path, labels):
+        self.file = open(path, "w", newline="")
+        self.writer = csv.writer(self.file)
+        self.header_written = False
+        self.labels = labels
+
+    def write(self, frame):
+        if not self.header_written:
+            header = ["host_time", "seq", "buttons"]
+            for i in range(len(frame.axes)):
+                name = (self.labels[i] if i < len(self.labels) else "axis%d" % (i + 1)).replace(" ", "_")
+                header += [name + suffix for suffix in ("_raw", "_avg", "_mapped", "_stable")]
+            self.writer.writerow(header)
+            self.header_written = True
+        row = ["" if frame.host_time is None else "%.6f" % frame.host_time,
+               frame.seq, "0x%x" % frame.buttons]
+        for axis in frame.axes:
+            row.extend(axis)
+        self.writer.writerow(row)
+
+    def close(self):
+        self.file.close()
+
+
+def handle(frames, args, labels, decoder, log, state):
+    for frame in frames:
+        if log:
+            log.write(frame)
+        state["latest"] = frame
+    now = time.monotonic()
+    if not args.quiet and state["latest"] and now - state["drawn"] >= 1.0 / args.fps:
+        render_table(state["latest"], labels, decoder)
+        state["drawn"] = now
+
+
+def run_file(args, labels, decoder, log):
+    state = {"latest": None, "drawn": 0.0}
+    with open(args.file, "rb") as source:
+        handle(decoder.feed(source.read()), args, labels, decoder, log, state)
+    if state["latest"] and not args.quiet:
+        render_table(state["latest"], labels, decoder)
+
+
+def run_port(args, labels, decoder, log):
+    import serial
+
+    state = {"latest": None, "drawn": 0.0}
+    raw_out = open(args.raw_out, "wb") if args.raw_out else None
+    with serial.Serial(args.port, 9600, timeout=0.05) as port:
+        time.sleep(0.2)
+        port.reset_input_buffer()
+        port.write(b"b")
+        port.flush()
+        try:
+            while True:
+                data = port.read(4096)
+                if not data:
+                    continue
+                if raw_out:
+                    raw_out.write(data)
+                handle(decoder.feed(data, time.perf_counter()), args, labels, decoder, log, state)
+        except KeyboardInterrupt:
+            pass
+        finally:
+            port.write(b"b")  # back to no telemetry
+            port.flush()
+            if raw_out:
+                raw_out.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="CDC serial port (e.g. COM5, /dev/ttyACM0)")
+    source.add_argument("--file", help="decode a saved raw capture instead of a port")
+    parser.add_argument("--csv", help="log every decoded frame to this CSV file")
+    parser.add_argument("--raw-out", help="also save the raw byte stream (with --port)")
+    parser.add_argument("--labels", help="comma-separated axis labels (default: stock table)")
+    parser.add_argument("--fps", type=float, default=10.0, help="table redraw rate")
+    parser.add_argument("--quiet", action="store_true", help="no table, just log")
+    args = parser.parse_args()
+
+    labels = args.labels.split(",") if args.labels else DEFAULT_LABELS
+    decoder = Decoder()
+    log = CsvLog(args.csv, labels) if args.csv else None
+    try:
+        if args.file:
+            run_file(args, labels, decoder, log)
+        else:
+            run_port(args, labels, decoder, log)
+    finally:
+        if log:
+            log.close()
+    print("frames=%d lost=%d bad=%d" % (decoder.frames, decoder.lost, decoder.bad), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,28 @@
+#!/bin/sh
+# Runs the input pipeline benchmark ([env:bench_avr]) on a simulated
+# ATmega32U4 and fails if a full axis scan costs more than the budget, or
+# if its output checksum differs from the bench's golden one:
+#   tools/simavr_bench.sh [budget_cycles]      (default 4000, 0.25 ms at 16 MHz)
+# Needs PlatformIO and simavr on the PATH; simavr echoes the benchmark's
+# USART1 output to its console.
+set -e
+BUDGET=${1:-4000}
+cd "$(dirname "$0")/.."
+
+pio run -e bench_avr
+OUTPUT=$(simavr -m atmega32u4 -f 16000000 .pio/build/bench_avr/firmware.elf 2>&1)
+echo "$OUTPUT"
+
+if echo "$OUTPUT" | grep -q "^FAIL"; then
+  exit 1 # the checksum no longer matches the golden one
+fi
+CYCLES=$(echo "$OUTPUT" | sed -n 's/.*scan cycles=\([0-9][0-9]*\).*/\1/p' | tail -n 1)
+if [ -z "$CYCLES" ]; then
+  echo "no result from the simulator" >&2
+  exit 2
+fi
+if [ "$CYCLES" -gt "$BUDGET" ]; then
+  echo "FAIL: full scan $CYCLES cycles, budget $BUDGET" >&2
+  exit 1
+fi
+echo "full scan $CYCLES cycles (budget $BUDGET)"
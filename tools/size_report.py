@@ -0,0 +1,90 @@
+"""Post-build flash and SRAM budget report (PlatformIO extra script).
+
+Hooked into [env:leonardo] with
+
+    extra_scripts = post:tools/size_report.py
+
+After every link it prints flash and static RAM use against the board's
+limits, the RAM left over for the stack, and the largest RAM and flash
+symbols, so feature work can see its headroom before anything overflows.
+Static RAM is .data + .bss; whatever is left is shared by the stack and the
+USB/Serial buffers, so the report warns once it drops below
+custom_stack_reserve (bytes, default 512).
+"""
+
+import re
+import subprocess
+
+Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+
+TOP_SYMBOLS = 8
+
+
+def section_sizes(size_tool, elf):
+    output = subprocess.check_output([size_tool, "-A", elf], universal_newlines=True)
+    sizes = {}
+    for line in output.splitlines():
+        match = re.match(r"^(\.\S+)\s+(\d+)\s+\d+", line)
+        if match:
+            sizes[match.group(1)] = int(match.group(2))
+    return sizes
+
+
+def largest_symbols(nm_tool, elf):
+    """Return ([(size, name)] in RAM, [(size, name)] in flash), largest first."""
+    output = subprocess.check_output([nm_tool, "-C", "-S", "--size-sort", "-r", elf],
+                                     universal_newlines=True)
+    ram, flash = [], []
+    for line in output.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) < 4:
+            continue
+        size, kind, name = int(parts[1], 16), parts[2], parts[3]
+        if kind in "bBdD":
+            ram.append((size, name))
+        elif kind in "tTrR":
+            flash.append((size, name))
+    return ram[:TOP_SYMBOLS], flash[:TOP_SYMBOLS]
+
+
+def bar(used, total, width=30):
+    filled = min(width, int(round(width * used / float(total)))) if total else 0
+    return "[" + "=" * filled + " " * (width - filled) + "]"
+
+
+def report(source, target, env):
+    elf = str(source[0])
+    board = env.BoardConfig()
+    flash_max = int(board.get("upload.maximum_size", 28672))
+    ram_max = int(board.get("upload.maximum_ram_size", 2560))
+    reserve = int(env.GetProjectOption("custom_stack_reserve", "512"))
+
+    size_tool = env.subst("$SIZETOOL") or "avr-size"
+    nm_tool = re.sub(r"size(\.exe)?$", r"nm\1", size_tool)
+
+    sizes = section_sizes(size_tool, elf)
+    flash = sizes.get(".text", 0) + sizes.get(".data", 0)
+    ram = sizes.get(".data", 0) + sizes.get(".bss", 0) + sizes.get(".noinit", 0)
+    free = ram_max - ram
+
+    print("")
+    print("Footprint (%s)" % env.subst("$PIOENV"))
+    print("  flash %s %5d / %d bytes, %d free" % (bar(flash, flash_max), flash, flash_max, flash_max - flash))
+    print("  sram  %s %5d / %d bytes, %d free for stack (reserve %d)" % (
+        bar(ram, ram_max), ram, ram_max, free, reserve))
+
+    try:
+        top_ram, top_flash = largest_symbols(nm_tool, elf)
+    except (OSError, subprocess.CalledProcessError):
+        top_ram, top_flash = [], []
+    if top_ram:
+        print("  largest in sram:  " + ", ".join("%s %d" % (name, size) for size, name in top_ram))
+    if top_flash:
+        print("  largest in flash: " + ", ".join("%s %d" % (name, size) for size, name in top_flash))
+
+    if free < reserve:
+        print("  WARNING: only %d bytes of SRAM left for the stack" % free)
+    print("")
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", report)  # noqa: F821